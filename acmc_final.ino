@@ -3,6 +3,18 @@
 */
 
 #define CONTROL_RATE 128 // Hz, powers of 2 are most reliable
+#define AUDIO_BLOCK_SIZE 32 // samples rendered per block in updateAudio()
+#define AUDIO_PERF 0			// 1 = time each render stage and publish the stats in the VISUAL block
+#define RENDER_BENCH 0		// 1 = render RENDER_BENCH_SECONDS offline at startup and report speed per stage
+#define RENDER_BENCH_SECONDS 20
+#define DUAL_CORE 0			// 1 = run control and telemetry on CONTROL_CORE, leaving the audio core to Mozzi
+#define CONTROL_CORE 0
+#define REVERB_LINES 0		// 0 = plate reverb; 4, 8 or 16 = the lighter FDN reverb with that many delay lines
+
+#if RENDER_BENCH || defined(OFFLINE_RENDER) // both report each stage's share of the render
+#undef AUDIO_PERF
+#define AUDIO_PERF 1
+#endif
 #include <Meap.h>		 // MEAP library, includes all dependent libraries, including all Mozzi modules
 
 Meap meap; // creates MEAP object to handle inputs and other MEAP library functions
@@ -14,11 +26,27 @@ MIDI_CREATE_INSTANCE(HardwareSerial, Serial1, MIDI); // defines MIDI in/out port
 #include <tables/sq8192_int16.h>  // loads square wave
 #include <tables/tri8192_int16.h> // loads triangle wave
 
+#include "adpcm_sample.h"
 #include "effects.h"
+#include "mailbox.h"
 #include "melody.h"
+#include "mix_bus.h"
+#include "param_snapshot.h"
+#include "perf.h"
 #include "phrase_model.h"
+#include "placement.h"
+#include "resampler.h"
+#include "sample_bank.h"
+#include "sine_tables.h"
+#include "sliced_drums.h"
+#include "time_stretch.h"
 #include "wind.h"
 
+#if DUAL_CORE && !defined(ESP32)
+#include <chrono>
+#include <thread>
+#endif
+
 EventDelay chordMetro;
 EventDelay melodyMetro;
 EventDelay clockMetro;
@@ -27,24 +55,26 @@ Chord currentChord;
 
 ChordVoice chordVoice;
 
-Melody<sin8192_int16_NUM_CELLS, AUDIO_RATE, int16_t> melody(sin8192_int16_DATA);
+PolyMelody<4, SINE_SMALL_CELLS, AUDIO_RATE, int16_t, true> melody(sineTable<SINE_SMALL_CELLS>());
 Melody<sin8192_int16_NUM_CELLS, AUDIO_RATE, int16_t> melody2(sin8192_int16_DATA, "Sin");
 int melodyNumber = 0;
 float swing = 0;
 
-// Effects
-Chorus chorus(0.0, 0.0, 0.5);
-Reverb reverb(0.0, 0.8, 0.3, 0.0);
+// Effects. The melody's inserts run as one chain; the reverb is on the send bus
+const unsigned int CHORUS_STAGE = 0;
+const unsigned int DELAY_STAGE = 1;
+using MelodyDelay = Delay<decltype(melody)::OUTPUT_BITS>;
+EffectChain<Chorus<>, MelodyDelay> melodyEffects;
+Chorus<> &chorus = melodyEffects.get<CHORUS_STAGE>();
+MelodyDelay &melodyDelay = melodyEffects.get<DELAY_STAGE>();
+#if REVERB_LINES
+LightReverb<REVERB_LINES> reverb(0.0, 0.8, 0.3, 1.0); // on the send bus, fully wet
+#else
+Reverb reverb(0.0, 0.8, 0.3, 1.0); // on the send bus, fully wet
+#endif
 
 bool modify = true;
 
-// Effect State Tracking
-float storedChorusFreq = 0.0;
-float storedChorusDepth = 0.0;
-float storedReverbDecay = 0.0;
-float storedReverbMix = 0.0;
-int systemVolume = 4095;
-
 enum PotCtrl { MELODY_RHYTHM, CHORUS, REVERB, MELODY_2_SOUND, WIND_CONTROL, DRUM_CONTROL };
 PotCtrl potCtrl = MELODY_RHYTHM;
 
@@ -54,17 +84,27 @@ int sixteenthLength = 500;
 
 State *currState;
 
-// Drums
-#include "neo_soul_drums.h"
-mSample<neo_soul_drums_NUM_CELLS, AUDIO_RATE, int16_t> neoSoulDrums(neo_soul_drums_DATA);
-bool playDrums = false; // Controlled by DIP 4
-float drumSpeed = 1.0;
-int drumVolume = 4095;
-
-// Announcements
-#include "landing_sample.h"
-mSample<landing_sample_NUM_CELLS, AUDIO_RATE, int16_t> landingSample(landing_sample_DATA);
-bool playAnnouncement = false;
+// Compiled-in samples, linked from assets.S; tools/embed_assets.py builds them from assets/ (README, Sample Assets)
+#if !__has_include("assets.h")
+#error "assets.h is missing: run python3 tools/embed_assets.py or build with its prebuild hook (README)"
+#endif
+#include "assets.h"
+
+// Drums: the loop's distinct hits, retriggered on the beat grid (tools/slice_drums.py)
+const DrumSliceMap neoSoulDrumSlices = {neo_soul_drums_SLICE_START, neo_soul_drums_SLICE_LENGTH,
+										neo_soul_drums_HIT_TIME,	neo_soul_drums_HIT_SLICE,
+										neo_soul_drums_HIT_COUNT,	neo_soul_drums_LOOP_STEPS};
+SlicedDrums<neo_soul_drums_SLICES_SAMPLES, neo_soul_drums_SLICES_BLOCK_SAMPLES, AUDIO_RATE>
+	neoSoulDrums(neo_soul_drums_SLICES_ADPCM, neoSoulDrumSlices);
+// Free mode: the whole loop, time-stretched to the speed pot
+AdpcmSample<neo_soul_drums_ADPCM_SAMPLES, neo_soul_drums_ADPCM_BLOCK_SAMPLES, AUDIO_RATE>
+	neoSoulDrumLoop(neo_soul_drums_ADPCM);
+TimeStretch<decltype(neoSoulDrumLoop)> stretchedDrums(neoSoulDrumLoop);
+
+// Announcements, streamed from LittleFS (the data/ folder) and converted from their own sample rate to AUDIO_RATE
+SampleBank<4> announcements;
+int landingAnnouncement = announcements.add("/landing_sample.wav");
+Resampler<decltype(announcements)> landingSample(announcements, AUDIO_RATE, AUDIO_RATE);
 
 // Performance
 bool isPerformanceRunning = false;
@@ -85,6 +125,125 @@ float windVolCurrent = 4095.0;
 float windCutCurrent = 255.0;
 float windResCurrent = 255.0;
 
+// Mix bus gain stages. The shifts and volume widths here are checked for int32 headroom at compile time
+using MelodyStage = GainStage<decltype(melody)::OUTPUT_BITS>;
+using Melody2Stage = GainStage<decltype(melody2)::OUTPUT_BITS, 0, 2>;
+using ChordStage = GainStage<ChordVoice::OUTPUT_BITS>;
+using DrumStage = GainStage<decltype(neoSoulDrums)::OUTPUT_BITS, 12, -8>; // drumVolume 0-4095
+using AnnouncementStage = GainStage<decltype(landingSample)::OUTPUT_BITS, 0, 2>;
+using WindStage = GainStage<Wind::OUTPUT_BITS>;
+// One reverb for the whole cabin: the sources inside it send to it at their send level (0-255); the wind is outside
+using ReverbSend = SendBus<16, 8, MelodyStage, Melody2Stage, ChordStage, DrumStage, AnnouncementStage>;
+using ReverbReturnStage = GainStage<ReverbSend::OUTPUT_BITS + decltype(reverb)::HEADROOM_BITS, 12, -12>; // 0-4095
+#if !REVERB_LINES
+static_assert(ReverbSend::OUTPUT_BITS <= decltype(reverb)::INPUT_BITS, "the plate saturates for a smaller input");
+#endif
+using MainBus = MixBus<21, 12, MelodyStage, Melody2Stage, ChordStage, DrumStage, AnnouncementStage, WindStage,
+					   ReverbReturnStage>;
+
+// Every setting the audio side uses, in one block. The control side edits its own copy (params) during a tick and
+// publishes it once at the end; the audio side picks up the latest version at a block boundary and keeps the copy it
+// applied in audioParams. Defaults match the audio objects' constructed state.
+struct AudioParams {
+	float chorusModFreq = 0.0;
+	float chorusModDepth = 0.0;
+	float reverbDecay = 0.0;
+	float reverbMix = 0.0;
+	float drumSpeed = 1.0; // synced: drum steps per sixteenth, 0.5, 1 or 2; free: loop tempo, 0.5-2.0
+	float swing = 0.0;
+	int32_t beatSamples = AUDIO_RATE / 2;
+	int16_t melody2Morph = 0;
+	int16_t melody2Volume = 4095;
+	int16_t drumVolume = 4095;
+	int16_t windVolume = 4095;
+	int16_t windCutoff = 255;
+	int16_t windResonance = 255;
+	int16_t systemVolume = 4095;
+	int16_t melodySend = 255; // reverb send levels, 0-255
+	int16_t melody2Send = 160;
+	int16_t chordSend = 128;
+	int16_t drumSend = 64;
+	int16_t announcementSend = 96;
+	int16_t melodyPan = 128; // 0 left, 128 centre, 256 right; the melody then widens through the stereo chorus
+	int16_t melody2Pan = 168;
+	int16_t chordPan = 88;
+	int16_t drumPan = 128;
+	int16_t announcementPan = 128;
+	int16_t windPan = 128;
+	bool melodyOn = false;		 // DIP 0
+	bool chorusOn = false;		 // DIP 1
+	bool reverbOn = false;		 // DIP 2
+	bool melody2On = false;		 // DIP 3
+	bool drumsOn = false;		 // DIP 4
+	bool drumsSynced = true;	 // pad 4 again: sliced hits on the beat grid, or the free-running loop
+	uint8_t delayDivision = 0;	 // pad 1 again: melody delay off (0), or its time in sixteenths (3, 2 or 4)
+	bool announcementOn = false; // DIP 5
+	bool windOn = false;		 // DIP 6
+#if REVERB_LINES
+	uint8_t reverbLines = REVERB_LINES; // lowered by adaptReverbLines() while the CPU is short
+#endif
+};
+
+AudioParams params;
+AudioParams audioParams;
+ParamSnapshot<AudioParams> paramSnapshot;
+
+// Note changes from control to audio. These are events rather than settings, so they travel in order through a
+// mailbox: applied immediately on a single core, or queued for the audio core's next block with DUAL_CORE.
+enum AudioTarget {
+	AUDIO_MELODY_NOTE_ON, // arg: MIDI note
+	AUDIO_MELODY_2_FREQ,
+	AUDIO_CHORD_RELEASE,
+	AUDIO_CHORD_NOTE_ON, // arg: MIDI note
+	AUDIO_DRUM_BEAT
+};
+
+struct AudioMessage {
+	AudioTarget target;
+	int32_t arg;
+	float value;
+};
+
+SpscMailbox<AudioMessage, 64> audioMailbox;
+
+// Block rendering: updateAudio() hands out frames from mixBlock and renders a new block when it runs dry. Sources are
+// mono and panned onto the stereo bus; the melody effects and the reverb return are stereo
+StereoFrame mixBlock[AUDIO_BLOCK_SIZE];
+int32_t scratchBlock[AUDIO_BLOCK_SIZE];
+StereoFrame stereoScratchBlock[AUDIO_BLOCK_SIZE];
+int32_t sendBlock[AUDIO_BLOCK_SIZE]; // reverb send bus, mono
+size_t mixBlockPos = AUDIO_BLOCK_SIZE;
+
+// Render plan: the nodes renderBlock() runs, in order, rebuilt by applyParams() whenever a module is switched on or
+// off. Disabled modules are simply not in the plan.
+struct RenderNode {
+	void (*render)(StereoFrame *out, size_t n);
+	PerfStage stage;
+};
+
+RenderNode renderPlan[PERF_STAGE_COUNT];
+int renderPlanLength = 0;
+
+#if REVERB_LINES
+// Share of a block's real-time budget renderBlock() takes, in 1/1024, smoothed over about 32 blocks. Written by the
+// audio side, read by adaptReverbLines()
+std::atomic<uint32_t> renderLoad{0};
+#endif
+
+// Called before they are defined. The Arduino build generates these; plain C++ builds of the sketch need them spelled
+// out (tools/render_offline.cpp)
+void applyParams(const AudioParams &next, bool force);
+uint8_t enableMask(const AudioParams &p);
+void buildRenderPlan(const AudioParams &p);
+void runControl();
+#if REVERB_LINES
+void adaptReverbLines();
+void trackRenderLoad(uint32_t ticks, size_t n);
+#endif
+#if RENDER_BENCH
+void runRenderBench();
+#endif
+
 // Helper for Visualizer Data
 String getVisualDescription(FlightPhase phase, String chordName) {
 	// Simple mapping based on phase and chord tension/quality
@@ -161,11 +320,26 @@ void setup() {
 	currState = new State("Dummy");
 	currState->addState(PhraseModel::createPhraseGraph(tonicMidi));
 
+	// Keep the audio path's tables off the flash cache: samples in PSRAM when there is any, noise in internal RAM
+	neoSoulDrums.setData(placeTable(neo_soul_drums_SLICES_ADPCM, neo_soul_drums_SLICES_BYTES, PLACE_PSRAM));
+	neoSoulDrumLoop.setData(placeTable(neo_soul_drums_ADPCM, neo_soul_drums_ADPCM_BYTES, PLACE_PSRAM));
+	wind.setNoiseTable(placeTable(WHITENOISE8192_DATA, WHITENOISE8192_NUM_CELLS));
+	// Up to a quarter note at the slowest tempo (2 s)
+	if (!melodyDelay.begin(2 * AUDIO_RATE))
+		Serial.println("Out of memory, no melody delay");
+	else if (melodyDelay.length() < 2 * AUDIO_RATE)
+		Serial.println("No PSRAM, melody delay limited to 125 ms");
+
 	// Drums
-	neoSoulDrums.setLoopingOn();
+	neoSoulDrumLoop.setLoopingOn();
 
-	// Announcements
-	landingSample.start();
+	// Announcements: loaded up front so DIP 5 starts the landing at once, the rest of a file streams in runControl()
+	if (!announcements.begin())
+		Serial.println("LittleFS mount failed, no announcements");
+	if (announcements.load(landingAnnouncement))
+		landingSample.setRates(announcements.rate(landingAnnouncement), AUDIO_RATE);
+	announcements.play(landingAnnouncement);
+	landingSample.reset();
 
 	// Melody 2 Configuration
 	melody2.addTable(tri8192_int16_DATA, "Tri"); // Index 1
@@ -173,12 +347,156 @@ void setup() {
 	melody2.addTable(saw8192_int16_DATA, "Saw"); // Index 3
 	melody2.setWave1(0);						 // Sine
 	melody2.setWave2(1);						 // Triangle
+	melody2.enableMipmaps();					 // Octave band-limited tri/sq/saw, baked in with the morph
+	melody2.enableBakedMorph();					 // One table lookup per sample; morphs are baked in updateControl()
+
+	applyParams(params, true);
+
+#if RENDER_BENCH
+	runRenderBench();
+#endif
+
+#if DUAL_CORE
+	startControlTask();
+#endif
 }
 
 void loop() {
 	audioHook(); // handles Mozzi audio generation behind the scenes
 }
 
+/** Applies a parameter block on the audio side, calling only the setters whose values changed (all of them with
+ * force)
+ */
+void applyParams(const AudioParams &next, bool force) {
+	const AudioParams &prev = audioParams;
+	if (force || next.melodyOn != prev.melodyOn)
+		melody.setEnabled(next.melodyOn);
+	if (force || next.chorusOn != prev.chorusOn)
+		melodyEffects.setEnabled(CHORUS_STAGE, next.chorusOn);
+	if (force || next.reverbOn != prev.reverbOn)
+		reverb.setEnabled(next.reverbOn);
+	if (force || next.delayDivision != prev.delayDivision) {
+		melodyEffects.setEnabled(DELAY_STAGE, next.delayDivision != 0);
+		if (next.delayDivision)
+			melodyDelay.setDivision((MelodyDelay::Division)next.delayDivision); // off keeps the time for the tail
+	}
+	if (force || next.beatSamples != prev.beatSamples)
+		melodyDelay.setTempo(next.beatSamples);
+	if (force || next.melody2On != prev.melody2On)
+		melody2.setEnabled(next.melody2On);
+	if (force || next.windOn != prev.windOn)
+		wind.setEnabled(next.windOn);
+	if (next.announcementOn && !prev.announcementOn)
+		landingSample.start(); // Restart the announcement each time DIP 5 goes up
+
+	if (force || next.chorusModFreq != prev.chorusModFreq)
+		chorus.setModFreq(next.chorusModFreq);
+	if (force || next.chorusModDepth != prev.chorusModDepth)
+		chorus.setModDepth(next.chorusModDepth);
+	if (force || next.reverbDecay != prev.reverbDecay)
+		reverb.setDecay(next.reverbDecay);
+#if REVERB_LINES
+	if (force || next.reverbLines != prev.reverbLines)
+		reverb.setLines(next.reverbLines);
+#endif
+	if (force || next.melody2Morph != prev.melody2Morph)
+		melody2.setMorph(next.melody2Morph);
+	if (force || next.melody2Volume != prev.melody2Volume)
+		melody2.setVolume(next.melody2Volume);
+	if (force || next.drumsSynced != prev.drumsSynced || next.drumSpeed != prev.drumSpeed || next.swing != prev.swing ||
+		next.beatSamples != prev.beatSamples) {
+		if (next.drumsSynced)
+			neoSoulDrums.setTempo(next.beatSamples, (uint8_t)(4 * next.drumSpeed), next.swing);
+		else
+			stretchedDrums.setSpeed(next.drumSpeed);
+	}
+	if (force || next.windVolume != prev.windVolume)
+		wind.setVolume(next.windVolume);
+	if (force || next.windCutoff != prev.windCutoff || next.windResonance != prev.windResonance)
+		wind.setCutOffAndResonance(next.windCutoff, next.windResonance);
+
+	bool replan = force || enableMask(next) != enableMask(prev) || next.drumsSynced != prev.drumsSynced;
+	audioParams = next;
+	if (replan) {
+		buildRenderPlan(audioParams);
+	}
+}
+
+/** Applies one note change on the audio side
+ */
+void applyAudioMessage(const AudioMessage &message) {
+	switch (message.target) {
+	case AUDIO_MELODY_NOTE_ON:
+		melody.play(message.arg);
+		break;
+	case AUDIO_MELODY_2_FREQ:
+		melody2.setFreq(message.value);
+		break;
+	case AUDIO_CHORD_RELEASE:
+		chordVoice.releaseAll();
+		break;
+	case AUDIO_CHORD_NOTE_ON:
+		chordVoice.noteOn(message.arg);
+		break;
+	case AUDIO_DRUM_BEAT:
+		neoSoulDrums.syncBeat();
+		break;
+	}
+}
+
+/** Sends a note change to the audio side. With DUAL_CORE this waits for room if the mailbox is full, which only
+ * happens if the audio core has stalled
+ */
+void postAudio(AudioTarget target, int32_t arg, float value) {
+	AudioMessage message = {target, arg, value};
+#if DUAL_CORE
+	while (!audioMailbox.push(message)) {
+		delay(1);
+	}
+#else
+	applyAudioMessage(message);
+#endif
+}
+
+void postAudio(AudioTarget target, float value) { postAudio(target, 0, value); }
+
+// Releases the sounding chord and starts the next; the release tails overlap the new chord in the voice pool
+void postChord(const Chord &chord) {
+	postAudio(AUDIO_CHORD_RELEASE, 0);
+	for (int i = 0; i < 4; ++i) {
+		postAudio(AUDIO_CHORD_NOTE_ON, chord.getMidiNote(i), 0);
+	}
+}
+
+#if DUAL_CORE
+#if defined(ESP32)
+void controlTask(void *) {
+	TickType_t lastWake = xTaskGetTickCount();
+	for (;;) {
+		runControl();
+		vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1000 / CONTROL_RATE));
+	}
+}
+#endif
+
+/** Runs runControl() at CONTROL_RATE away from the audio: pinned to CONTROL_CORE on the board, on a std::thread
+ * elsewhere
+ */
+void startControlTask() {
+#if defined(ESP32)
+	xTaskCreatePinnedToCore(controlTask, "control", 8192, NULL, 1, NULL, CONTROL_CORE);
+#else
+	std::thread([] {
+		for (;;) {
+			runControl();
+			std::this_thread::sleep_for(std::chrono::microseconds(1000000 / CONTROL_RATE));
+		}
+	}).detach();
+#endif
+}
+#endif
+
 void printStatus() {
 	Serial.println("\n--- Status ---");
 
@@ -196,7 +514,7 @@ void printStatus() {
 
 	// DIP 0: Melody
 	Serial.print("DIP 0 (Melody): ");
-	Serial.print(melody.isEnabled() ? "ON" : "OFF");
+	Serial.print(params.melodyOn ? "ON" : "OFF");
 	Serial.print(" | Swing: ");
 	Serial.print(swing);
 	Serial.print(", Length: ");
@@ -204,56 +522,60 @@ void printStatus() {
 
 	// DIP 1: Chorus
 	Serial.print("DIP 1 (Chorus): ");
-	Serial.print(chorus.isEnabled() ? "ON" : "OFF");
+	Serial.print(params.chorusOn ? "ON" : "OFF");
 	Serial.print(" | Freq: ");
-	Serial.print(storedChorusFreq);
+	Serial.print(params.chorusModFreq);
 	Serial.print(", Depth: ");
-	Serial.println(storedChorusDepth);
+	Serial.print(params.chorusModDepth);
+	Serial.print(" | Delay: ");
+	Serial.println(params.delayDivision == 0 ? "OFF" : (params.delayDivision == MelodyDelay::DOTTED_EIGHTH ? "1/8."
+								: (params.delayDivision == MelodyDelay::EIGHTH ? "1/8" : "1/4")));
 
 	// DIP 2: Reverb
 	Serial.print("DIP 2 (Reverb): ");
-	Serial.print(reverb.isEnabled() ? "ON" : "OFF");
+	Serial.print(params.reverbOn ? "ON" : "OFF");
 	Serial.print(" | Decay: ");
-	Serial.print(storedReverbDecay);
+	Serial.print(params.reverbDecay);
 	Serial.print(", Mix: ");
-	Serial.println(storedReverbMix);
+	Serial.println(params.reverbMix);
 
 	// DIP 3: Melody2
 	Serial.print("DIP 3 (Melody2): ");
-	Serial.print(melody2.isEnabled() ? "ON" : "OFF");
+	Serial.print(params.melody2On ? "ON" : "OFF");
 	Serial.print(" | Morph: ");
-	Serial.print(melody2.getMorphStatus());
+	Serial.print(melody2.getMorphStatus(params.melody2Morph));
 	Serial.print(" (");
-	Serial.print(melody2.getMorph());
+	Serial.print(params.melody2Morph);
 	Serial.print(", Vol: ");
-	Serial.print(melody2.getVolume());
+	Serial.print(params.melody2Volume);
 	Serial.println(")");
 
 	// Dip 4: Drums
 	Serial.print("DIP 4 (Drums): ");
-	Serial.print(playDrums ? "ON" : "OFF");
+	Serial.print(params.drumsOn ? "ON" : "OFF");
+	Serial.print(params.drumsSynced ? " | Synced" : " | Free");
 	Serial.print(" | Speed: ");
-	Serial.print(drumSpeed);
+	Serial.print(params.drumSpeed);
 	Serial.print(", Vol: ");
-	Serial.println(drumVolume);
+	Serial.println(params.drumVolume);
 
 	// DIP 5: Sample
 	Serial.print("DIP 5 (Sample): ");
-	Serial.print(playAnnouncement ? "ON" : "OFF");
+	Serial.print(params.announcementOn ? "ON" : "OFF");
 	Serial.print(" | Speed: ");
-	Serial.print(drumSpeed);
+	Serial.print(params.drumSpeed);
 	Serial.print(", Vol: ");
-	Serial.println(drumVolume);
+	Serial.println(params.drumVolume);
 
 	// DIP 6: Wind
 	Serial.print("DIP 6 (Wind): ");
-	Serial.print(wind.isEnabled() ? "ON" : "OFF");
+	Serial.print(params.windOn ? "ON" : "OFF");
 	Serial.print(" | Cutoff: ");
-	Serial.print(wind.getCutoff());
+	Serial.print(params.windCutoff);
 	Serial.print(", Res: ");
-	Serial.print(wind.getResonance());
+	Serial.print(params.windResonance);
 	Serial.print(", Vol: ");
-	Serial.print(wind.getVolume());
+	Serial.print(params.windVolume);
 	Serial.println(")");
 
 	Serial.print("Modify Mode: ");
@@ -339,7 +661,7 @@ void printStatus() {
 	// Melody
 	Serial.print("\"mel\":{");
 	Serial.print("\"on\":");
-	Serial.print(melody.isEnabled() ? 1 : 0);
+	Serial.print(params.melodyOn ? 1 : 0);
 	Serial.print(",\"sw\":");
 	Serial.print(swing);
 	Serial.print(",\"len\":");
@@ -349,64 +671,66 @@ void printStatus() {
 	// Chorus
 	Serial.print("\"cho\":{");
 	Serial.print("\"on\":");
-	Serial.print(chorus.isEnabled() ? 1 : 0);
+	Serial.print(params.chorusOn ? 1 : 0);
 	Serial.print(",\"fr\":");
-	Serial.print(storedChorusFreq);
+	Serial.print(params.chorusModFreq);
 	Serial.print(",\"dp\":");
-	Serial.print(storedChorusDepth);
+	Serial.print(params.chorusModDepth);
 	Serial.print("},");
 
 	// Reverb
 	Serial.print("\"rev\":{");
 	Serial.print("\"on\":");
-	Serial.print(reverb.isEnabled() ? 1 : 0);
+	Serial.print(params.reverbOn ? 1 : 0);
 	Serial.print(",\"dec\":");
-	Serial.print(storedReverbDecay);
+	Serial.print(params.reverbDecay);
 	Serial.print(",\"mix\":");
-	Serial.print(storedReverbMix);
+	Serial.print(params.reverbMix);
 	Serial.print("},");
 
 	// Melody 2
 	Serial.print("\"mel2\":{");
 	Serial.print("\"on\":");
-	Serial.print(melody2.isEnabled() ? 1 : 0);
+	Serial.print(params.melody2On ? 1 : 0);
 	Serial.print(",\"mph\":\"");
-	Serial.print(melody2.getMorphStatus());
+	Serial.print(melody2.getMorphStatus(params.melody2Morph));
 	Serial.print("\"");
 	Serial.print(",\"vol\":");
-	Serial.print(melody2.getVolume());
+	Serial.print(params.melody2Volume);
 	Serial.print("},");
 
 	// Drums
 	Serial.print("\"drm\":{");
 	Serial.print("\"on\":");
-	Serial.print(playDrums ? 1 : 0);
+	Serial.print(params.drumsOn ? 1 : 0);
+	Serial.print(",\"sync\":");
+	Serial.print(params.drumsSynced ? 1 : 0);
 	Serial.print(",\"spd\":");
-	Serial.print(drumSpeed);
+	Serial.print(params.drumSpeed);
 	Serial.print(",\"vol\":");
-	Serial.print(drumVolume);
+	Serial.print(params.drumVolume);
 	Serial.print("},");
 
 	// Sample
 	Serial.print("\"smp\":{");
 	Serial.print("\"on\":");
-	Serial.print(playAnnouncement ? 1 : 0);
+	Serial.print(params.announcementOn ? 1 : 0);
 	Serial.print(",\"spd\":");
-	Serial.print(drumSpeed); // Note: using drumSpeed as per original printStatus
+	Serial.print(params.drumSpeed); // Note: using drumSpeed as per original printStatus
 	Serial.print(",\"vol\":");
-	Serial.print(drumVolume);
+	Serial.print(params.drumVolume);
 	Serial.print("},");
 
 	// Wind
 	Serial.print("\"wnd\":{");
 	Serial.print("\"on\":");
-	Serial.print(wind.isEnabled() ? 1 : 0);
+	Serial.print(params.windOn ? 1 : 0);
 	Serial.print(",\"cut\":");
-	Serial.print(wind.getCutoff());
+	Serial.print(params.windCutoff);
 	Serial.print(",\"res\":");
-	Serial.print(wind.getResonance());
+	Serial.print(params.windResonance);
 	Serial.print(",\"vol\":");
-	Serial.print(wind.getVolume());
+	Serial.print(params.windVolume);
 	Serial.print("},");
 
 	// Controls
@@ -441,14 +765,31 @@ void printStatus() {
 	Serial.print("]");
 
 	Serial.print("}"); // End details
+
+#if AUDIO_PERF
+	Serial.print(",");
+	perf.printJson(AUDIO_BLOCK_SIZE);
+#endif
 	Serial.println("}");
 }
 
-/** Called automatically at rate specified by CONTROL_RATE macro, most of your
- * code should live in here
+/** Called automatically at rate specified by CONTROL_RATE macro. With DUAL_CORE the control work runs in its own
+ * task instead, and only audio-side housekeeping happens here
  */
 void updateControl() {
+#if !DUAL_CORE
+	runControl();
+#endif
+	// Mozzi calls this on the audio core, so the audio-owned morph table is safe to bake here in both modes
+	melody2.bakeStep();
+}
+
+/** Reads the inputs, advances the phrase model, posts note changes to the audio side and publishes the tick's
+ * parameters
+ */
+void runControl() {
 	meap.readInputs();
+	announcements.fill();
 	// ---------- YOUR updateControl CODE BELOW ----------
 	static int lastPot0 = -1;
 	static int lastPot1 = -1;
@@ -462,7 +803,8 @@ void updateControl() {
 	if (chordMetro.ready()) {
 		currState = currState->nextState();
 		currentChord = currState->getChord();
-		chordVoice.setChord(currentChord);
+		postChord(currentChord);
+		postAudio(AUDIO_DRUM_BEAT, 0);
 		updateWindState();
 
 		if (currState == &authenticCadence || currState == &halfCadence || currState == &deceptiveCadence) {
@@ -486,8 +828,8 @@ void updateControl() {
 			melodyMetro.start(sixteenthLength / 4 * (1 - swing));
 		}
 		int note = currentChord.getMidiNote(melodyNumber);
-		melody.setFreq(mtof(note + 12));
-		melody2.setFreq(mtof(note + 12));
+		postAudio(AUDIO_MELODY_NOTE_ON, note + 12, 0);
+		postAudio(AUDIO_MELODY_2_FREQ, mtof(note + 12));
 		melodyNumber = (melodyNumber + 1) % 4;
 	}
 
@@ -505,20 +847,23 @@ void updateControl() {
 		}
 	} else if (potCtrl == DRUM_CONTROL) {
 		// Drum Control
-		// Pot 0: Speed (0.5x to 2.0x)
+		// Pot 0: Half time, normal or double time when synced; loop tempo (0.5x to 2.0x) when free
 		// Pot 1: Volume
 		if (modify) {
-			float speedVal = map(meap.pot_vals[0], 0, 4095, 50, 200) / 100.0;
-			if (abs(speedVal - drumSpeed) > 0.01) {
-				drumSpeed = speedVal;
-				neoSoulDrums.setSpeed(drumSpeed);
+			if (params.drumsSynced) {
+				params.drumSpeed = meap.pot_vals[0] < 1365 ? 0.5 : (meap.pot_vals[0] < 2730 ? 1.0 : 2.0);
+			} else {
+				float speedVal = map(meap.pot_vals[0], 0, 4095, 50, 200) / 100.0;
+				if (abs(speedVal - params.drumSpeed) > 0.01) {
+					params.drumSpeed = speedVal;
+				}
 			}
 
-			drumVolume = meap.pot_vals[1];
+			params.drumVolume = meap.pot_vals[1];
 		}
-		systemVolume = meap.volume_val;
+		params.systemVolume = meap.volume_val;
 	} else {
-		systemVolume = meap.volume_val;
+		params.systemVolume = meap.volume_val;
 	}
 
 	// Performance Logic
@@ -534,21 +879,17 @@ void updateControl() {
 
 	// Effects
 	if (potCtrl == CHORUS && modify) {
-		storedChorusFreq = map(meap.pot_vals[0], 0, 4095, 0, 500) / 100.0;
-		storedChorusDepth = meap.pot_vals[1] / 4095.0;
-		chorus.setModFreq(storedChorusFreq);
-		chorus.setModDepth(storedChorusDepth);
+		params.chorusModFreq = map(meap.pot_vals[0], 0, 4095, 0, 500) / 100.0;
+		params.chorusModDepth = meap.pot_vals[1] / 4095.0;
 	}
 	if (potCtrl == REVERB && modify) {
-		storedReverbDecay = meap.pot_vals[0] / 4095.0;
-		storedReverbMix = meap.pot_vals[1] / 4095.0;
-		reverb.setDecay(storedReverbDecay);
-		reverb.setMix(storedReverbMix);
+		params.reverbDecay = meap.pot_vals[0] / 4095.0;
+		params.reverbMix = meap.pot_vals[1] / 4095.0;
 	}
 
 	if (potCtrl == MELODY_2_SOUND && modify) {
-		melody2.setMorph(meap.pot_vals[0]);
-		melody2.setVolume(meap.pot_vals[1]);
+		params.melody2Morph = meap.pot_vals[0];
+		params.melody2Volume = constrain(meap.pot_vals[1], 0, 4095);
 	}
 
 	if (abs(meap.pot_vals[0] - lastPot0) > potEpsilon || abs(meap.pot_vals[1] - lastPot1) > potEpsilon) {
@@ -563,39 +904,261 @@ void updateControl() {
 	windCutCurrent += (windCutTarget - windCutCurrent) * windAlpha;
 	windResCurrent += (windResTarget - windResCurrent) * windAlpha;
 
-	wind.setVolume((int)windVolCurrent);
-	wind.setCutOffAndResonance((int)windCutCurrent, (int)windResCurrent);
+	params.windVolume = constrain((int)windVolCurrent, 0, 4095);
+	params.windCutoff = (int)windCutCurrent;
+	params.windResonance = (int)windResCurrent;
+
+#if REVERB_LINES
+	adaptReverbLines();
+#endif
+
+	// The drums follow the sequencer's beat and swing
+	params.beatSamples = (int32_t)sixteenthLength * AUDIO_RATE / 1000;
+	params.swing = swing;
 
 	// For visualizer
 	if (clockMetro.ready()) {
 		clockMetro.start(1000);
 		printStatus();
 	}
+
+	paramSnapshot.publish(params);
 }
 
-/** Called automatically at rate specified by AUDIO_RATE macro, for calculating
- * samples sent to DAC, too much code in here can disrupt your output
+#if REVERB_LINES
+/** Steps the light reverb down a tier while the render takes over 85% of the real-time budget and back up once it is
+ * under half, at most every quarter second so the load can settle in between
  */
-AudioOutput_t updateAudio() {
-	int64_t melody_out = 0;
-	melody_out = melody.next();
-	melody_out = chorus.next(melody_out);
-	melody_out = reverb.next(melody_out);
+void adaptReverbLines() {
+	static unsigned long lastStep = 0;
+	if (millis() - lastStep < 250)
+		return;
+	uint32_t load = renderLoad.load(std::memory_order_relaxed);
+	if (load > 870 && params.reverbLines > 4)
+		params.reverbLines /= 2;
+	else if (load < 512 && params.reverbLines < REVERB_LINES)
+		params.reverbLines *= 2;
+	else
+		return;
+	lastStep = millis();
+}
+
+/** Folds the time one block of n frames took into renderLoad
+ */
+void AUDIO_HOT trackRenderLoad(uint32_t ticks, size_t n) {
+	uint64_t budget = (uint64_t)perfTicksPerMicro() * 1000000 * n / AUDIO_RATE;
+	int32_t load = (int32_t)(((uint64_t)ticks << 10) / budget);
+	int32_t smoothed = (int32_t)renderLoad.load(std::memory_order_relaxed);
+	renderLoad.store(smoothed + ((load - smoothed) >> 5), std::memory_order_relaxed);
+}
+#endif
 
-	melody_out += melody2.next() << 2;
+// Render nodes. Each source renders into scratchBlock and mixes through its gain stage, panned, into the stereo bus
+// and, inside the cabin, the reverb send. The melody node only renders; the melody effects node after it pans the
+// result, runs the stereo chain and mixes it
+void AUDIO_HOT renderSilenceNode(StereoFrame *, size_t n) { memset(scratchBlock, 0, n * sizeof(int32_t)); }
 
-	int64_t out_sample = chordVoice.next() + melody_out;
-	if (playDrums) {
-		out_sample += (neoSoulDrums.next() * drumVolume) >> 8; // Apply drum volume
+void AUDIO_HOT renderMelodyNode(StereoFrame *, size_t n) { melody.render(scratchBlock, n); }
+
+void AUDIO_HOT renderMelodyEffectsNode(StereoFrame *out, size_t n) {
+	Pan pan(audioParams.melodyPan);
+	for (size_t i = 0; i < n; ++i) {
+		stereoScratchBlock[i] = pan.place(scratchBlock[i]);
 	}
-	if (playAnnouncement) {
-		out_sample += landingSample.next() << 2;
+	melodyEffects.render(stereoScratchBlock, n);
+	MelodyStage::mix<ReverbSend>(out, sendBlock, stereoScratchBlock, n, audioParams.melodySend);
+}
+
+void AUDIO_HOT renderMelody2Node(StereoFrame *out, size_t n) {
+	melody2.render(scratchBlock, n);
+	Melody2Stage::mix<ReverbSend>(out, sendBlock, scratchBlock, n, audioParams.melody2Send,
+								  Pan(audioParams.melody2Pan));
+}
+
+void AUDIO_HOT renderChordNode(StereoFrame *out, size_t n) {
+	chordVoice.render(scratchBlock, n);
+	ChordStage::mix<ReverbSend>(out, sendBlock, scratchBlock, n, audioParams.chordSend, Pan(audioParams.chordPan));
+}
+
+void AUDIO_HOT renderDrumNode(StereoFrame *out, size_t n) {
+	neoSoulDrums.render(scratchBlock, n);
+	DrumStage::mix<ReverbSend>(out, sendBlock, scratchBlock, n, audioParams.drumVolume, audioParams.drumSend,
+							   Pan(audioParams.drumPan));
+}
+
+void AUDIO_HOT renderStretchedDrumNode(StereoFrame *out, size_t n) {
+	stretchedDrums.render(scratchBlock, n);
+	DrumStage::mix<ReverbSend>(out, sendBlock, scratchBlock, n, audioParams.drumVolume, audioParams.drumSend,
+							   Pan(audioParams.drumPan));
+}
+
+void AUDIO_HOT renderAnnouncementNode(StereoFrame *out, size_t n) {
+	landingSample.render(scratchBlock, n);
+	AnnouncementStage::mix<ReverbSend>(out, sendBlock, scratchBlock, n, audioParams.announcementSend,
+									   Pan(audioParams.announcementPan));
+}
+
+// One plate reverb over everything sent to it; the Mix pot sets the return level. With DIP 2 down the sends stop and
+// the tail rings out
+void AUDIO_HOT renderReverbNode(StereoFrame *out, size_t n) {
+	if (!reverb.isEnabled())
+		memset(sendBlock, 0, n * sizeof(int32_t));
+	ReverbSend::clamp(sendBlock, n);
+	reverb.render(sendBlock, stereoScratchBlock, n);
+	if (!reverb.isAwake())
+		return;
+	ReverbReturnStage::mix(out, stereoScratchBlock, n, (int32_t)(audioParams.reverbMix * 4095));
+}
+
+void AUDIO_HOT renderWindNode(StereoFrame *out, size_t n) {
+	wind.render(scratchBlock, n);
+	WindStage::mix(out, scratchBlock, n, Pan(audioParams.windPan));
+}
+
+void AUDIO_HOT renderOutputNode(StereoFrame *out, size_t n) { MainBus::master(out, n, audioParams.systemVolume); }
+
+/** One bit per DIP-switched module, so routing changes can be spotted with a single compare
+ */
+uint8_t enableMask(const AudioParams &p) {
+	return p.melodyOn | p.chorusOn << 1 | p.reverbOn << 2 | p.melody2On << 3 | p.drumsOn << 4 |
+		   p.announcementOn << 5 | p.windOn << 6;
+}
+
+void addRenderNode(void (*render)(StereoFrame *out, size_t n), PerfStage stage) {
+	renderPlan[renderPlanLength].render = render;
+	renderPlan[renderPlanLength].stage = stage;
+	++renderPlanLength;
+}
+
+/** Rebuilds the render plan for the modules enabled in p
+ */
+void buildRenderPlan(const AudioParams &p) {
+	renderPlanLength = 0;
+	// The effects always stay in the plan: switched off they ring out their tails, and with nothing to process they
+	// sleep (effect_chain.h, effects.h)
+	addRenderNode(p.melodyOn ? renderMelodyNode : renderSilenceNode, PERF_MELODY);
+	addRenderNode(renderMelodyEffectsNode, PERF_MELODY_FX);
+	if (p.melody2On)
+		addRenderNode(renderMelody2Node, PERF_MELODY_2);
+	addRenderNode(renderChordNode, PERF_CHORD);
+	if (p.drumsOn)
+		addRenderNode(p.drumsSynced ? renderDrumNode : renderStretchedDrumNode, PERF_DRUMS);
+	if (p.announcementOn)
+		addRenderNode(renderAnnouncementNode, PERF_ANNOUNCEMENT);
+	if (p.windOn)
+		addRenderNode(renderWindNode, PERF_WIND);
+	addRenderNode(renderReverbNode, PERF_REVERB);
+	addRenderNode(renderOutputNode, PERF_OUTPUT);
+}
+
+/** Renders n stereo frames of the full mix into out, with system volume applied
+ */
+void AUDIO_HOT renderBlock(StereoFrame *out, size_t n) {
+#if DUAL_CORE
+	AudioMessage message;
+	while (audioMailbox.pop(message)) {
+		applyAudioMessage(message);
+	}
+#endif
+	if (paramSnapshot.fetch()) {
+		applyParams(paramSnapshot.current(), false);
 	}
+#if REVERB_LINES
+	uint32_t startTicks = perfTicks();
+#endif
+	perfBlockStart();
+
+	memset(out, 0, n * sizeof(StereoFrame));
+	memset(sendBlock, 0, n * sizeof(int32_t));
+	for (int i = 0; i < renderPlanLength; ++i) {
+		renderPlan[i].render(out, n);
+		perfLap(renderPlan[i].stage);
+	}
+	perfBlockEnd();
+#if REVERB_LINES
+	trackRenderLoad(perfTicks() - startTicks, n);
+#endif
+}
 
-	// Wind
-	out_sample += wind.next();
+#if RENDER_BENCH
+/** Renders RENDER_BENCH_SECONDS of the performance with every module on, as fast as the CPU allows, and prints the
+ * speed relative to real time and each stage's share of the render time. The chord advances every beat.
+ */
+void runRenderBench() {
+	AudioParams restoreParams = audioParams;
+	AudioParams benchParams = audioParams;
+	benchParams.melodyOn = true;
+	benchParams.chorusOn = true;
+	benchParams.delayDivision = MelodyDelay::DOTTED_EIGHTH;
+	benchParams.reverbOn = true;
+	benchParams.melody2On = true;
+	benchParams.drumsOn = true;
+	benchParams.announcementOn = true;
+	benchParams.windOn = true;
+	applyParams(benchParams, false);
+
+	const unsigned long totalBlocks = (unsigned long)RENDER_BENCH_SECONDS * AUDIO_RATE / AUDIO_BLOCK_SIZE;
+	const unsigned long blocksPerNote = (unsigned long)sixteenthLength * AUDIO_RATE / 4000 / AUDIO_BLOCK_SIZE;
+	StereoFrame benchBlock[AUDIO_BLOCK_SIZE];
+	int benchNote = 0;
+	perf.reset();
+
+	unsigned long startMicros = micros();
+	for (unsigned long block = 0; block < totalBlocks; ++block) {
+		if (block % blocksPerNote == 0) {
+			if (benchNote == 0) {
+				currState = currState->nextState();
+				currentChord = currState->getChord();
+				chordVoice.setChord(currentChord);
+				neoSoulDrums.syncBeat();
+			}
+			int note = currentChord.getMidiNote(benchNote);
+			melody.play(note + 12);
+			melody2.setFreq(mtof(note + 12));
+			benchNote = (benchNote + 1) % 4;
+		}
+		renderBlock(benchBlock, AUDIO_BLOCK_SIZE);
+	}
+	unsigned long elapsedMicros = micros() - startMicros;
+
+	const PerfWindow &timings = perf.liveWindow(); // audio isn't running yet, so nothing swapped windows mid-bench
+	uint64_t allTicks = 0;
+	for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+		allTicks += timings.stages[i].totalTicks;
+	}
+	Serial.println("\n--- Render Bench ---");
+	Serial.print("Rendered ");
+	Serial.print(RENDER_BENCH_SECONDS);
+	Serial.print(" s in ");
+	Serial.print(elapsedMicros / 1000.0);
+	Serial.print(" ms: ");
+	Serial.print(RENDER_BENCH_SECONDS * 1000000.0 / elapsedMicros);
+	Serial.println("x real time");
+	for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+		Serial.print(perfStageName(i));
+		Serial.print(": ");
+		Serial.print(allTicks ? 100.0 * timings.stages[i].totalTicks / allTicks : 0.0);
+		Serial.print("%, p99 ");
+		Serial.print(timings.stages[i].percentile(99) / (float)perfTicksPerMicro());
+		Serial.println(" us/block");
+	}
+	Serial.println("--------------------");
+
+	applyParams(restoreParams, false);
+	perf.reset();
+}
+#endif
 
-	return StereoOutput::fromNBit(22, (out_sample * systemVolume) >> 12, (out_sample * systemVolume) >> 12);
+/** Called automatically at rate specified by AUDIO_RATE macro, for calculating
+ * samples sent to DAC, too much code in here can disrupt your output
+ */
+AudioOutput_t AUDIO_HOT updateAudio() {
+	if (mixBlockPos == AUDIO_BLOCK_SIZE) {
+		renderBlock(mixBlock, AUDIO_BLOCK_SIZE);
+		mixBlockPos = 0;
+	}
+	StereoFrame frame = mixBlock[mixBlockPos++];
+	return StereoOutput::fromNBit(22, frame.l, frame.r);
 }
 
 /**
@@ -620,6 +1183,15 @@ void updateTouch(int number, bool pressed) {
 	case 1:
 		if (pressed) { // Pad 1 pressed
 			Serial.println("t1 pressed");
+			if (potCtrl == CHORUS) {
+				// Pressed again: step the melody delay through dotted eighth, eighth, quarter and off
+				static const uint8_t divisions[] = {0, MelodyDelay::DOTTED_EIGHTH, MelodyDelay::EIGHTH,
+													MelodyDelay::QUARTER};
+				int i = 0;
+				while (divisions[i] != params.delayDivision)
+					++i;
+				params.delayDivision = divisions[(i + 1) % 4];
+			}
 			potCtrl = CHORUS;
 		} else { // Pad 1 released
 			Serial.println("t1 released");
@@ -644,6 +1216,11 @@ void updateTouch(int number, bool pressed) {
 	case 4:
 		if (pressed) { // Pad 4 pressed
 			Serial.println("t4 pressed");
+			if (potCtrl == DRUM_CONTROL) {
+				// Pressed again: switch between synced slices and the free-running loop, on the nearest synced speed
+				params.drumsSynced = !params.drumsSynced;
+				params.drumSpeed = params.drumSpeed < 0.75 ? 0.5 : (params.drumSpeed < 1.5 ? 1.0 : 2.0);
+			}
 			potCtrl = DRUM_CONTROL;
 		} else { // Pad 4 released
 			Serial.println("t4 released");
@@ -721,65 +1298,64 @@ void updateDip(int number, bool up) {
 	case 0:
 		if (up) { // DIP 0 up
 			Serial.println("d0 up");
-			melody.setEnabled(true);
+			params.melodyOn = true;
 		} else { // DIP 0 down
 			Serial.println("d0 down");
-			melody.setEnabled(false);
+			params.melodyOn = false;
 		}
 		break;
 	case 1:
 		if (up) { // DIP 1 up
 			Serial.println("d1 up");
-			chorus.setEnabled(true);
+			params.chorusOn = true;
 		} else { // DIP 1 down
 			Serial.println("d1 down");
-			chorus.setEnabled(false);
+			params.chorusOn = false;
 		}
 		break;
 	case 2:
 		if (up) { // DIP 2 up
 			Serial.println("d2 up");
-			reverb.setEnabled(true);
+			params.reverbOn = true;
 		} else { // DIP 2 down
 			Serial.println("d2 down");
-			reverb.setEnabled(false);
+			params.reverbOn = false;
 		}
 		break;
 	case 3:
 		if (up) { // DIP 3 up
 			Serial.println("d3 up");
-			melody2.setEnabled(true);
+			params.melody2On = true;
 		} else { // DIP 3 down
 			Serial.println("d3 down");
-			melody2.setEnabled(false);
+			params.melody2On = false;
 		}
 		break;
 	case 4:
 		if (up) { // DIP 4 up
 			Serial.println("d4 up");
-			playDrums = true;
+			params.drumsOn = true;
 		} else { // DIP 4 down
 			Serial.println("d4 down");
-			playDrums = false;
+			params.drumsOn = false;
 		}
 		break;
 	case 5:
 		if (up) { // DIP 5 up
 			Serial.println("d5 up");
-			playAnnouncement = true;
-			landingSample.start();
+			params.announcementOn = true;
 		} else { // DIP 5 down
 			Serial.println("d5 down");
-			playAnnouncement = false;
+			params.announcementOn = false;
 		}
 		break;
 	case 6:
 		if (up) { // DIP 6 up
 			Serial.println("d6 up");
-			wind.setEnabled(true);
+			params.windOn = true;
 		} else { // DIP 6 down
 			Serial.println("d6 down");
-			wind.setEnabled(false);
+			params.windOn = false;
 		}
 		break;
 	case 7:
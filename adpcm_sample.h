@@ -0,0 +1,143 @@
+#ifndef ADPCM_SAMPLE_H
+#define ADPCM_SAMPLE_H
+
+#include "placement.h"
+
+#include <Meap.h>
+
+// Player for IMA ADPCM samples written by tools/adpcm_encode.py, a drop-in for mSample: 4 bits per sample instead
+// of 16. Codes are decoded as the play position reaches them, one or two per output sample up to 2x speed, with
+// linear interpolation between neighbours for speeds other than 1. Each BLOCK_SAMPLES block starts with the decoder
+// state it needs, so playback can start or loop at any block; playRange() plays one block-aligned stretch of the data,
+// e.g. a hit packed by tools/slice_drums.py. The sample is stored at UPDATE_RATE.
+template <unsigned int NUM_SAMPLES, unsigned int BLOCK_SAMPLES, unsigned int UPDATE_RATE>
+class AdpcmSample {
+	static_assert((BLOCK_SAMPLES & (BLOCK_SAMPLES - 1)) == 0, "block size must be a power of two");
+
+  private:
+	static constexpr unsigned int HEADER_BYTES = 4;
+	static constexpr unsigned int BLOCK_BYTES = HEADER_BYTES + BLOCK_SAMPLES / 2;
+
+	const uint8_t *data;
+	const uint8_t *block = nullptr; // codes of the block being decoded
+	uint32_t cursor = 0;			// next sample to decode
+	uint32_t begin = 0;				// range played, [begin, end)
+	uint32_t end = NUM_SAMPLES;
+	int32_t predictor = 0;
+	int32_t stepIndex = 0;
+	int32_t previous = 0; // decoded samples either side of the play position
+	int32_t current = 0;
+	uint32_t frac = 0; // play position between previous and current, Q16
+	uint32_t increment = 1 << 16;
+	bool looping = false;
+	bool playing = false;
+
+	static int32_t step(int32_t index) {
+		static const int16_t steps[89] = {
+			7,	   8,	  9,	 10,	11,	   12,	  13,	 14,	16,	   17,	  19,	 21,	23,	   25,	  28,
+			31,	   34,	  37,	 41,	45,	   50,	  55,	 60,	66,	   73,	  80,	 88,	97,	   107,	  118,
+			130,   143,	  157,	 173,	190,   209,	  230,	 253,	279,   307,	  337,	 371,	408,   449,	  494,
+			544,   598,	  658,	 724,	796,   876,	  963,	 1060,	1166,  1282,  1411,	 1552,	1707,  1878,  2066,
+			2272,  2499,  2749,	 3024,	3327,  3660,  4026,	 4428,	4871,  5358,  5894,	 6484,	7132,  7845,  8630,
+			9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+		return steps[index];
+	}
+
+	int32_t decode() {
+		if (cursor == end) {
+			if (!looping) {
+				playing = false;
+				return 0;
+			}
+			cursor = begin;
+		}
+		unsigned int offset = cursor & (BLOCK_SAMPLES - 1);
+		if (offset == 0) {
+			block = data + (cursor / BLOCK_SAMPLES) * BLOCK_BYTES;
+			predictor = (int16_t)(block[0] | block[1] << 8);
+			stepIndex = block[2];
+			block += HEADER_BYTES;
+		}
+		++cursor;
+
+		static const int8_t indexAdjust[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+		int32_t code = (block[offset >> 1] >> ((offset & 1) * 4)) & 0xf;
+		int32_t s = step(stepIndex);
+		int32_t delta = s >> 3;
+		if (code & 4)
+			delta += s;
+		if (code & 2)
+			delta += s >> 1;
+		if (code & 1)
+			delta += s >> 2;
+		predictor += (code & 8) ? -delta : delta;
+		predictor = predictor < -32768 ? -32768 : (predictor > 32767 ? 32767 : predictor);
+		stepIndex += indexAdjust[code & 7];
+		stepIndex = stepIndex < 0 ? 0 : (stepIndex > 88 ? 88 : stepIndex);
+		return predictor;
+	}
+
+  public:
+	// Magnitude bound of render() output for the mix bus: 16-bit samples
+	static constexpr int OUTPUT_BITS = 15;
+
+	AdpcmSample(const uint8_t *adpcm_data) : data(adpcm_data) { start(); }
+
+	// Swaps in a copy of the same data, e.g. one placed in RAM; playback carries on where it was
+	void setData(const uint8_t *adpcm_data) {
+		block = adpcm_data + (block - data);
+		data = adpcm_data;
+	}
+
+	void setLoopingOn() { looping = true; }
+
+	void setLoopingOff() { looping = false; }
+
+	// Playback rate relative to the recording, 1.0 for the original speed
+	void setSpeed(float speed) { increment = (uint32_t)(speed * 65536.0f); }
+
+	void start() {
+		cursor = begin;
+		frac = 0;
+		playing = true;
+		previous = decode();
+		current = decode();
+	}
+
+	// Plays length samples from sample from, which must start a block, once
+	void playRange(uint32_t from, uint32_t length) {
+		begin = from;
+		end = from + length;
+		looping = false;
+		start();
+	}
+
+	void stop() { playing = false; }
+
+	bool isPlaying() { return playing; }
+
+	// Samples left before the end of the range, counted from the decoder (two ahead of the output at speed 1)
+	uint32_t remaining() { return playing ? end - cursor : 0; }
+
+	int32_t AUDIO_HOT next() {
+		if (!playing)
+			return 0;
+		int32_t out = previous + (((current - previous) * (int32_t)(frac >> 1)) >> 15);
+		frac += increment;
+		while (frac >= (1 << 16) && playing) {
+			frac -= 1 << 16;
+			previous = current;
+			current = decode();
+		}
+		return out;
+	}
+
+	// Renders n samples into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		for (size_t i = 0; i < n; ++i) {
+			buf[i] = next();
+		}
+	}
+};
+
+#endif
@@ -768,6 +768,9 @@ function handleVisualData(data) {
 	if (data.details) {
 		updateTechnicalDisplay(data.details);
 	}
+	if (data.perf) {
+		updatePerfDisplay(data.perf);
+	}
 
 	// Store for change detection
 	currentState.prevPhase = data.phase;
@@ -1588,3 +1591,23 @@ function updateTechnicalDisplay(d) {
 		set('tech-vals', `[${d.vals[0]}, ${d.vals[1]}]`);
 	}
 }
+
+// Audio render timings, only present when the sketch is built with AUDIO_PERF.
+// Each stage is [min, mean, max, p99] in ticks per block; tpu is ticks per microsecond, bud the ticks in one block.
+function updatePerfDisplay(p) {
+	const set = (id, val) => {
+		const el = document.getElementById(id);
+		if (el) el.textContent = val;
+	};
+	const us = ticks => (ticks / p.tpu).toFixed(1);
+
+	['mel', 'fx', 'rev', 'mel2', 'chd', 'drm', 'smp', 'wnd', 'out'].forEach(stage => {
+		const s = p[stage];
+		set(`tech-perf-${stage}`, s ? `${us(s[1])} / ${us(s[3])}` : 'OFF');
+	});
+
+	if (p.blk && p.bud) {
+		const load = (100 * p.blk[3] / p.bud).toFixed(0);
+		set('tech-perf-load', `${load}% p99, ${(100 * p.blk[2] / p.bud).toFixed(0)}% max`);
+	}
+}
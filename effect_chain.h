@@ -0,0 +1,177 @@
+#ifndef EFFECT_CHAIN_H
+#define EFFECT_CHAIN_H
+
+#include "placement.h"
+#include "stereo.h"
+
+#include <stdint.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Most samples an EffectChain hands a stage's beginBlock() and endBlock() at a time
+constexpr size_t EFFECT_BLOCK = 32;
+
+namespace EffectChainDetail {
+template <class E, class = void> struct HasBlockHooks : std::false_type {};
+template <class E>
+struct HasBlockHooks<E, std::void_t<decltype(std::declval<E &>().beginBlock(size_t())),
+									decltype(std::declval<E &>().endBlock(size_t()))>> : std::true_type {};
+
+template <class E, class = void> struct HasHold : std::false_type {};
+template <class E> struct HasHold<E, std::void_t<decltype(std::declval<E &>().hold())>> : std::true_type {};
+
+template <class E, class = void> struct HasWake : std::false_type {};
+template <class E> struct HasWake<E, std::void_t<decltype(std::declval<E &>().wake())>> : std::true_type {};
+} // namespace EffectChainDetail
+
+// Effects in series, composed at compile time: EffectChain<Chorus<>, Delay<>> runs every stage on a sample before
+// the next sample, in one loop over the block, and each stage's next() is a direct call the compiler can inline, so a
+// stage added to the chain costs its own work and nothing per sample on top. Stages are default-constructed; set them
+// up through get<I>(). They are switched by a bit each in the chain's enable mask rather than by their own state, and
+// ring out and sleep like TailEnableable: a stage switched off keeps running on silence, its tail added to what passes
+// through, and any stage sleeps once its input and output have stayed below SILENCE for HOLD samples, or for its own
+// hold() when it has one. Which stages run is settled once per block, so the per-sample branches always go the same
+// way. A stage with beginBlock(n) and endBlock(n) has them called around every EFFECT_BLOCK samples or fewer, e.g. to
+// move its delay line in bursts, and one with wake() has it called before the first block after a sleep, e.g. to
+// forget what its line held from before. Samples are whatever the stages' next() takes and returns: int32_t, or StereoFrame
+// for a stereo chain.
+template <class... Effects>
+class EffectChain {
+	static constexpr unsigned int STAGES = sizeof...(Effects);
+	static_assert(STAGES > 0 && STAGES <= 32, "1 to 32 stages");
+
+  public:
+	static constexpr int32_t SILENCE = 16;
+	static constexpr uint32_t HOLD = 8192;
+
+  private:
+	std::tuple<Effects...> effects;
+	uint32_t enabled = 0;
+	uint32_t running = 0;	// stages awake in the last render
+	uint32_t quiet[STAGES]; // samples each stage's input and output have been below SILENCE
+
+	template <unsigned int I>
+	uint32_t holdOf() {
+		if constexpr (EffectChainDetail::HasHold<std::tuple_element_t<I, decltype(effects)>>::value)
+			return std::get<I>(effects).hold();
+		else
+			return HOLD;
+	}
+
+	template <unsigned int... I>
+	uint32_t awakeStages(bool live, std::integer_sequence<unsigned int, I...>) {
+		// A stage wakes when sound reaches its input, which a stage running ahead of it may supply. Stages that
+		// stay asleep pass their input through
+		const uint32_t holds[STAGES] = {holdOf<I>()...};
+		uint32_t awake = 0;
+		for (unsigned int i = 0; i < STAGES; ++i) {
+			if ((live && (enabled >> i & 1)) || quiet[i] < holds[i]) {
+				awake |= 1u << i;
+				live = true;
+			}
+		}
+		return awake;
+	}
+
+	template <unsigned int I>
+	void wake(uint32_t woken) {
+		if constexpr (EffectChainDetail::HasWake<std::tuple_element_t<I, decltype(effects)>>::value) {
+			if (woken >> I & 1)
+				std::get<I>(effects).wake();
+		}
+	}
+
+	template <unsigned int I>
+	void beginBlock(size_t n, uint32_t awake) {
+		if constexpr (EffectChainDetail::HasBlockHooks<std::tuple_element_t<I, decltype(effects)>>::value) {
+			if (awake >> I & 1)
+				std::get<I>(effects).beginBlock(n);
+		}
+	}
+
+	template <unsigned int I>
+	void endBlock(size_t n, uint32_t awake) {
+		if constexpr (EffectChainDetail::HasBlockHooks<std::tuple_element_t<I, decltype(effects)>>::value) {
+			if (awake >> I & 1)
+				std::get<I>(effects).endBlock(n);
+		}
+	}
+
+	// Stage I on one sample: its output, or with the stage switched off the sample plus its tail
+	template <unsigned int I, class Sample>
+	Sample AUDIO_HOT step(Sample x, uint32_t awake, int32_t &peak) {
+		if (!(awake >> I & 1))
+			return x;
+		bool on = enabled >> I & 1;
+		Sample in = on ? x : Sample{};
+		Sample y = std::get<I>(effects).next(in);
+		int32_t m = magnitude(in) > magnitude(y) ? magnitude(in) : magnitude(y);
+		peak = m > peak ? m : peak;
+		return on ? y : x + y;
+	}
+
+	template <class Sample, unsigned int... I>
+	void AUDIO_HOT renderStages(Sample *buf, size_t n, uint32_t awake, std::integer_sequence<unsigned int, I...>) {
+		int32_t peak[STAGES] = {};
+		(wake<I>(awake & ~running), ...);
+		for (size_t start = 0; start < n; start += EFFECT_BLOCK) {
+			size_t count = n - start < EFFECT_BLOCK ? n - start : EFFECT_BLOCK;
+			(beginBlock<I>(count, awake), ...);
+			for (size_t k = start; k < start + count; ++k) {
+				Sample x = buf[k];
+				((x = step<I>(x, awake, peak[I])), ...);
+				buf[k] = x;
+			}
+			(endBlock<I>(count, awake), ...);
+		}
+		for (unsigned int i = 0; i < STAGES; ++i) {
+			if (awake >> i & 1)
+				quiet[i] = peak[i] <= SILENCE ? quiet[i] + n : 0;
+		}
+	}
+
+	template <unsigned int... I>
+	bool anyAwake(std::integer_sequence<unsigned int, I...>) {
+		return ((quiet[I] < holdOf<I>()) || ...);
+	}
+
+  public:
+	EffectChain() {
+		for (unsigned int i = 0; i < STAGES; ++i) {
+			quiet[i] = UINT32_MAX / 2;
+		}
+	}
+
+	template <unsigned int I>
+	auto &get() {
+		return std::get<I>(effects);
+	}
+
+	void setEnabled(unsigned int stage, bool on) { enabled = on ? enabled | 1u << stage : enabled & ~(1u << stage); }
+
+	bool isEnabled(unsigned int stage) { return enabled >> stage & 1; }
+
+	// One bit per stage, stage 0 in bit 0
+	void setEnabledMask(uint32_t mask) { enabled = mask; }
+
+	uint32_t enabledMask() { return enabled; }
+
+	// Whether any stage is still running: on with recent input, or ringing out
+	bool isAwake() { return anyAwake(std::make_integer_sequence<unsigned int, STAGES>()); }
+
+	// Processes n samples of buf in place
+	template <class Sample>
+	void AUDIO_HOT render(Sample *buf, size_t n) {
+		bool live = false;
+		for (size_t i = 0; i < n && !live; ++i) {
+			live = magnitude(buf[i]) > SILENCE;
+		}
+		uint32_t awake = awakeStages(live, std::make_integer_sequence<unsigned int, STAGES>());
+		if (awake)
+			renderStages(buf, n, awake, std::make_integer_sequence<unsigned int, STAGES>());
+		running = awake;
+	}
+};
+
+#endif
@@ -2,36 +2,368 @@
 #define EFFECTS_H_
 
 #include <Meap.h>        // MEAP library, includes all dependent libraries, including all Mozzi modules
+#include "effect_chain.h"
 #include "enableable.h"
+#include "fdn_reverb.h"
+#include "placement.h"
+#include "sine_tables.h"
+#include "stereo.h"
+
+// Enableable for effects with a tail, rendering a stereo return from a mono input. Switched off, the effect stops
+// taking input but keeps running on silence, its tail added to the dry signal, until the tail has stayed below SILENCE
+// for HOLD samples; then it stops entirely. Left on, it likewise sleeps once its input and output have both been that
+// quiet for that long, and wakes on the first block with input. HOLD has to cover the effect's longest internal delay,
+// so nothing still in flight is dropped.
+template<int32_t SILENCE = 16, uint32_t HOLD = 8192>
+class TailEnableable : public Enableable {
+private:
+	uint32_t quiet = HOLD; // samples that input and output have been below SILENCE
+
+	template<typename T>
+	static bool isSilent(const T *buf, size_t n) {
+		for (size_t i = 0; i < n; ++i) {
+			if (magnitude(buf[i]) > SILENCE)
+				return false;
+		}
+		return true;
+	}
+
+protected:
+	// Runs process(in, out, n) on n samples, or on silence while switched off, with the dry input passed through to
+	// out while switched off or asleep
+	template<typename T, class Process>
+	void AUDIO_HOT renderWithTail(const T *in, StereoFrame *out, size_t n, Process process) {
+		bool enabled = isEnabled();
+		bool silentIn = !enabled || isSilent(in, n);
+		if (silentIn && quiet >= HOLD) {
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = StereoFrame::mono(in[i]);
+			}
+			return;
+		}
+		if (enabled) {
+			process(in, out, n);
+			quiet = silentIn && isSilent(out, n) ? quiet + n : 0;
+			return;
+		}
+		bool silentOut = true;
+		for (size_t done = 0; done < n;) {
+			const T zeros[32] = {};
+			size_t count = n - done < 32 ? n - done : 32;
+			process(zeros, out + done, count);
+			silentOut = silentOut && isSilent(out + done, count);
+			for (size_t i = 0; i < count; ++i) {
+				out[done + i] = out[done + i] + StereoFrame::mono(in[done + i]);
+			}
+			done += count;
+		}
+		quiet = silentOut ? quiet + n : 0;
+	}
+
+public:
+	// Whether the effect is still running: on with recent input, or ringing out
+	bool isAwake() {
+		return quiet < HOLD;
+	}
+};
+
+// Quadrature stereo chorus, run as a stage of an EffectChain (effect_chain.h), which switches it and puts it to sleep.
+// One delay line of the mono sum is read at two taps swept by the same sine LFO a quarter turn apart, left and right,
+// so the channels' pitch wobble is always out of step: the image widens rather than just thickening, for the cost of
+// one extra tap. The delay sweeps around 12 ms by up to modDepth * 8 ms; CELLS (a power of two) has to hold 20 ms.
+template<unsigned int CELLS = 1024>
+class Chorus {
+	static_assert((CELLS & (CELLS - 1)) == 0, "CELLS must be a power of two");
+
+private:
+	static constexpr int FRAC_BITS = 12; // tap position and gains
+	static constexpr int32_t CENTRE = (int32_t)(0.012f * AUDIO_RATE) << FRAC_BITS;
+	static constexpr float SWEEP = 0.008f * AUDIO_RATE;
+	static_assert((CENTRE >> FRAC_BITS) + SWEEP + 2 < CELLS, "CELLS too short for the sweep");
+
+	const int16_t *sine = sineTable<SINE_SMALL_CELLS>();
+	int32_t line[CELLS] = {};
+	uint32_t pos = 0;
+	uint32_t phase = 0;
+	uint32_t phaseStep = 0;
+	int32_t depth = 0;	 // sweep in samples, Q8, so depth times the halved sine fits int32
+	int32_t dryGain = 0; // Q12
+	int32_t wetGain = 0; // Q12
+
+	// Line read delay samples back, FRAC_BITS fraction, with linear interpolation
+	int32_t tap(int32_t delay) {
+		uint32_t at = pos - (uint32_t)(delay >> FRAC_BITS);
+		int32_t frac = delay & ((1 << FRAC_BITS) - 1);
+		int32_t a = line[at & (CELLS - 1)], b = line[(at - 1) & (CELLS - 1)];
+		return a + (((b - a) * frac) >> FRAC_BITS);
+	}
+
+public:
+	Chorus(float modFreq = 0.2, float modDepth = 0.05, float mix = 0.5) {
+		setModFreq(modFreq);
+		setModDepth(modDepth);
+		setMix(mix);
+	}
+
+	// LFO rate in Hz
+	void setModFreq(float hz) { phaseStep = (uint32_t)(hz * (4294967296.0f / AUDIO_RATE)); }
+
+	// Sweep depth, 0-1
+	void setModDepth(float d) { depth = (int32_t)(d * SWEEP * 256); }
+
+	// Wet share of the output, 0-1
+	void setMix(float mix) {
+		wetGain = (int32_t)(mix * (1 << FRAC_BITS));
+		dryGain = (1 << FRAC_BITS) - wetGain;
+	}
+
+	StereoFrame AUDIO_HOT next(StereoFrame in) {
+		static constexpr int SINE_SHIFT = 32 - 10; // SINE_SMALL_CELLS = 2^10
+		static_assert(SINE_SMALL_CELLS == 1 << 10, "update SINE_SHIFT");
+		line[pos & (CELLS - 1)] = in.mid();
+		phase += phaseStep;
+		int32_t sl = sine[phase >> SINE_SHIFT] >> 1, sr = sine[(phase + 0x40000000u) >> SINE_SHIFT] >> 1;
+		int32_t wl = tap(CENTRE + ((depth * sl) >> 10)); // Q8 * Q14 to Q12
+		int32_t wr = tap(CENTRE + ((depth * sr) >> 10));
+		++pos;
+		return {(in.l * dryGain + wl * wetGain) >> FRAC_BITS, (in.r * dryGain + wr * wetGain) >> FRAC_BITS};
+	}
+};
+
+// Tempo-synced stereo delay, run as a stage of an EffectChain (effect_chain.h). Its time is a number of sixteenth notes
+// of the beat given to setTempo() in samples (a quarter note, like sixteenthLength), so the echoes stay on the grid as
+// the tempo moves; a change of time crossfades over one block. Each repeat goes back through a lowpass and a low cut,
+// so it comes back darker and thinner, and with ping-pong on the echoes alternate between the channels. The line can
+// be seconds long, so begin() puts it in PSRAM when the board has one. beginBlock() and endBlock() move it in bursts of
+// up to EFFECT_BLOCK frames, which hides PSRAM latency, and next() only touches two small buffers in internal RAM.
+// Repeats are held within 2^BITS, the input's bound, so the output stays within it too.
+template<int BITS = 17>
+class Delay {
+public:
+	enum Division : uint8_t { EIGHTH = 2, DOTTED_EIGHTH = 3, QUARTER = 4 }; // in sixteenths
+
+private:
+	static constexpr int GAIN_BITS = 12;
+	static constexpr int32_t LIMIT = (int32_t)1 << BITS;
+	static constexpr int32_t LOW_CUT = 78; // one-pole at about 100 Hz, Q12
+	static_assert(BITS + 1 + GAIN_BITS <= 31, "filter products overflow int32");
+
+	StereoFrame *line = nullptr;
+	uint32_t frames = 0;
+	uint32_t writePos = 0;
+	uint32_t filled = 0; // frames written since the line was allocated or last woke, up to frames
+	uint32_t delay = EFFECT_BLOCK;
+	uint32_t target = EFFECT_BLOCK;
+	int32_t beatSamples = 16384;
+	Division division;
+	StereoFrame delayed[EFFECT_BLOCK]; // this block's output of the line
+	StereoFrame written[EFFECT_BLOCK]; // this block's input to it
+	size_t pos = 0;
+	StereoFrame lowpass = {};
+	StereoFrame lowCut = {}; // Q12: with the fraction kept, the slow filter settles on its input instead of near it
+	int32_t feedbackGain; // Q12
+	int32_t dampingCoeff; // Q12: share of the lowpass state kept
+	int32_t dryGain;	  // Q12
+	int32_t wetGain;	  // Q12
+	bool pingPong = true;
+
+	static int32_t clamp(int32_t x) { return x > LIMIT ? LIMIT : (x < -LIMIT ? -LIMIT : x); }
+
+	// Copies n frames from d frames back into out, wrapping. Frames older than filled read as silence
+	void read(uint32_t d, StereoFrame *out, size_t n) {
+		size_t stale = d > filled ? d - filled : 0;
+		stale = stale < n ? stale : n;
+		memset(out, 0, stale * sizeof(StereoFrame));
+		d -= stale;
+		n -= stale;
+		out += stale;
+		uint32_t at = writePos >= d ? writePos - d : writePos + frames - d;
+		size_t first = frames - at < n ? frames - at : n;
+		memcpy(out, line + at, first * sizeof(StereoFrame));
+		memcpy(out + first, line, (n - first) * sizeof(StereoFrame));
+	}
+
+	void updateTarget() {
+		uint32_t d = (uint32_t)beatSamples * division / 4;
+		target = d < EFFECT_BLOCK ? EFFECT_BLOCK : (d > frames && frames ? frames : d);
+	}
 
-template<typename T = int32_t>
-class Chorus : public mChorus<T>, public Enableable {
 public:
-	Chorus(float modFreq = 0.2, float modDepth = 0.05, float mix = 0.5)
-		: mChorus<T>(modFreq, modDepth, mix) {
-			// There's currently a bug in Meap where the constructor doesn't set the mix
-			mChorus<T>::setMix(mix);
+	Delay(Division division = DOTTED_EIGHTH, float feedback = 0.4, float damping = 0.5, float mix = 0.3)
+		: division(division) {
+		setFeedback(feedback);
+		setDamping(damping);
+		setMix(mix);
+	}
+
+	// Allocates a line of maxFrames, in where, or failing that fallbackFrames of internal RAM. Call once from setup(),
+	// before the stage is first switched on; until then, or when neither fits, the delay stays silent. Times longer
+	// than the line are cut to it
+	bool begin(uint32_t maxFrames, TablePlacement where = PLACE_PSRAM, uint32_t fallbackFrames = 4096) {
+		line = (StereoFrame *)placeBuffer(maxFrames * sizeof(StereoFrame), where);
+		frames = maxFrames;
+		if (line == nullptr && where != PLACE_INTERNAL) {
+			line = (StereoFrame *)placeBuffer(fallbackFrames * sizeof(StereoFrame), PLACE_INTERNAL);
+			frames = fallbackFrames;
 		}
+		frames = line != nullptr && frames >= EFFECT_BLOCK ? frames : 0;
+		filled = 0;
+		updateTarget();
+		delay = target;
+		return frames > 0;
+	}
+
+	// Length of the line in frames, 0 before begin()
+	uint32_t length() { return frames; }
+
+	// Beat (quarter note) in samples
+	void setTempo(int32_t samples) {
+		beatSamples = samples;
+		updateTarget();
+	}
+
+	void setDivision(Division d) {
+		division = d;
+		updateTarget();
+	}
+
+	// Share of each repeat fed back, 0-0.95
+	void setFeedback(float feedback) {
+		feedbackGain = (int32_t)((feedback < 0.95f ? feedback : 0.95f) * (1 << GAIN_BITS));
+	}
 
-	T next(T inSample) {
-		if (isEnabled()) {
-			return mChorus<T>::next(inSample);
+	// High-frequency loss per repeat: 0 keeps the repeats bright, 1 leaves them dull
+	void setDamping(float damping) { dampingCoeff = (int32_t)(0.95f * damping * (1 << GAIN_BITS)); }
+
+	// Wet share of the output, 0-1
+	void setMix(float mix) {
+		wetGain = (int32_t)(mix * (1 << GAIN_BITS));
+		dryGain = (1 << GAIN_BITS) - wetGain;
+	}
+
+	// Echoes alternate between left and right, from the mono sum of the input
+	void setPingPong(bool on) { pingPong = on; }
+
+	// Samples of silence before the chain may put it to sleep: a whole pass of the line on top of the usual hold, so
+	// no echo still in flight is lost
+	uint32_t hold() { return delay + 8192; }
+
+	// The line stood still while the chain slept; what it holds is from before, so it reads as empty until rewritten
+	void wake() { filled = 0; }
+
+	void AUDIO_HOT beginBlock(size_t n) {
+		pos = 0;
+		if (frames == 0) {
+			memset(delayed, 0, n * sizeof(StereoFrame));
+			return;
+		}
+		read(delay, delayed, n);
+		if (target != delay) {
+			StereoFrame next[EFFECT_BLOCK];
+			read(target, next, n);
+			for (size_t i = 0; i < n; ++i) {
+				delayed[i].l += (next[i].l - delayed[i].l) * (int32_t)i / (int32_t)n;
+				delayed[i].r += (next[i].r - delayed[i].r) * (int32_t)i / (int32_t)n;
+			}
+			delay = target;
 		}
-		return inSample;
+	}
+
+	StereoFrame AUDIO_HOT next(StereoFrame in) {
+		StereoFrame d = delayed[pos];
+		lowpass.l = d.l + (((lowpass.l - d.l) * dampingCoeff) >> GAIN_BITS);
+		lowpass.r = d.r + (((lowpass.r - d.r) * dampingCoeff) >> GAIN_BITS);
+		lowCut.l += (lowpass.l - (lowCut.l >> GAIN_BITS)) * LOW_CUT;
+		lowCut.r += (lowpass.r - (lowCut.r >> GAIN_BITS)) * LOW_CUT;
+		int32_t fl = ((lowpass.l - (lowCut.l >> GAIN_BITS)) * feedbackGain) >> GAIN_BITS;
+		int32_t fr = ((lowpass.r - (lowCut.r >> GAIN_BITS)) * feedbackGain) >> GAIN_BITS;
+		if (pingPong)
+			written[pos] = {clamp(in.mid() + fr), clamp(fl)};
+		else
+			written[pos] = {clamp(in.l + fl), clamp(in.r + fr)};
+		++pos;
+		return {(in.l * dryGain + d.l * wetGain) >> GAIN_BITS, (in.r * dryGain + d.r * wetGain) >> GAIN_BITS};
+	}
+
+	void AUDIO_HOT endBlock(size_t n) {
+		if (frames == 0)
+			return;
+		size_t first = frames - writePos < n ? frames - writePos : n;
+		memcpy(line + writePos, written, first * sizeof(StereoFrame));
+		memcpy(line, written + first, (n - first) * sizeof(StereoFrame));
+		writePos = writePos + n >= frames ? writePos + n - frames : writePos + n;
+		filled = filled + n < frames ? filled + n : frames;
 	}
 };
 
-template<typename T = int32_t>
-class Reverb : public mPlateReverb<T>, public Enableable {
+// Schroeder allpass of LENGTH samples: flat in level, scrambled in phase. Two of different lengths turn one signal into
+// a decorrelated pair
+template<unsigned int LENGTH>
+class Allpass {
+private:
+	static constexpr int32_t GAIN = 2048; // 0.5, Q12
+	int32_t line[LENGTH] = {};
+	unsigned int pos = 0;
+
+public:
+	int32_t next(int32_t x) {
+		int32_t d = line[pos];
+		int32_t v = x + ((d * GAIN) >> 12);
+		line[pos] = v;
+		pos = pos + 1 == LENGTH ? 0 : pos + 1;
+		return d - ((v * GAIN) >> 12);
+	}
+};
+
+// Mono in, stereo out: the plate's output goes to left and right through allpasses of different lengths, so the
+// channels decorrelate as the tail builds up. Its input stays within 2^INPUT_BITS; the plate's tank can build a
+// sustained input up to several times that, so the output saturates at HEADROOM_BITS above it
+template<typename T = int32_t, int IN_BITS = 16>
+class Reverb : public mPlateReverb<T>, public TailEnableable<> {
+private:
+	Allpass<149> spreadLeft; // 4.5 ms
+	Allpass<223> spreadRight; // 6.8 ms
+
+	static int32_t saturate(int32_t x) {
+		const int32_t limit = int32_t(1) << (INPUT_BITS + HEADROOM_BITS);
+		return x > limit ? limit : (x < -limit ? -limit : x);
+	}
+
 public:
+	// Extra magnitude bits the plate tail may add on top of its input
+	static constexpr int HEADROOM_BITS = 1;
+	// Magnitude bound of the input the saturation is set for
+	static constexpr int INPUT_BITS = IN_BITS;
+
 	Reverb (float decay = 0.6, float damping = 0.8, float bandwidth = 0.3, float mix = 0.5)
 		: mPlateReverb<T>(decay, damping, bandwidth, mix) {}
 
-	T next(T inSample) {
-		if (isEnabled()) {
-			return mPlateReverb<T>::next(inSample);
-		}
-		return inSample;
+	// Renders n stereo frames into out from n samples of in, ringing out and sleeping as set by TailEnableable
+	void AUDIO_HOT render(const T *in, StereoFrame *out, size_t n) {
+		renderWithTail(in, out, n, [this](const T *src, StereoFrame *dst, size_t count) {
+			for (size_t i = 0; i < count; ++i) {
+				int32_t y = mPlateReverb<T>::next(src[i]);
+				dst[i] = {saturate(spreadLeft.next(y)), saturate(spreadRight.next(y))};
+			}
+		});
+	}
+};
+
+// Lighter stand-in for Reverb with the same controls: a feedback delay network of LINES lines (4, 8 or 16), which
+// setLines() can lower at runtime when the CPU budget is tight. Its left and right come decorrelated from the network
+template<unsigned int LINES = 16, typename T = int32_t>
+class LightReverb : public FdnReverb<LINES>, public TailEnableable<> {
+public:
+	static constexpr int HEADROOM_BITS = FdnReverb<LINES>::HEADROOM_BITS;
+
+	LightReverb(float decay = 0.6, float damping = 0.8, float bandwidth = 0.3, float mix = 0.5)
+		: FdnReverb<LINES>(decay, damping, bandwidth, mix) {}
+
+	// Renders n stereo frames into out from n samples of in, ringing out and sleeping as set by TailEnableable
+	void AUDIO_HOT render(const T *in, StereoFrame *out, size_t n) {
+		renderWithTail(in, out, n, [this](const T *src, StereoFrame *dst, size_t count) {
+			FdnReverb<LINES>::render(src, dst, count);
+		});
 	}
 };
 
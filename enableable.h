@@ -6,8 +6,6 @@ private:
 	bool isEnabled_ = false;
 
 public:
-	virtual ~Enableable() = default;
-
 	void setEnabled(bool enabled) {
 		isEnabled_ = enabled;
 	}
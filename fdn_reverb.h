@@ -0,0 +1,233 @@
+#ifndef FDN_REVERB_H
+#define FDN_REVERB_H
+
+#include "placement.h"
+#include "stereo.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef AUDIO_RATE
+#define AUDIO_RATE 32768 // host builds without Mozzi, e.g. tools/reverb_bench.cpp
+#endif
+
+// Fixed-point feedback delay network reverb, a lighter alternative to mPlateReverb. Up to LINES delay lines (4, 8 or
+// 16, 30-90 ms each) feed back into each other through a Hadamard matrix, which mixes them without adding energy and
+// costs only additions. Each line has a one-pole lowpass for damping and a gain that sets the decay time exactly from
+// its length. Cost grows with the number of lines while the echo density falls with fewer, so setLines() can trade
+// quality for CPU at runtime, down from the LINES the memory was sized for. Left and right take the lines with two
+// orthogonal sign patterns, so the channels are decorrelated but equally loud. tools/reverb_bench.cpp measures cycles
+// per sample and decay accuracy per tier on the host.
+template <unsigned int LINES = 16>
+class FdnReverb {
+	static_assert(LINES == 4 || LINES == 8 || LINES == 16, "4, 8 or 16 lines");
+
+  private:
+	// Prime lengths (31-90 ms at 32768 Hz), ordered so the first 4 and first 8 each spread over the whole range
+	static constexpr uint16_t LENGTHS[16] = {1021, 1453, 1913, 2477, 1187, 1657, 2179, 2797,
+											 1103, 1297, 1559, 1777, 2039, 2309, 2617, 2953};
+	static constexpr int COEFF_BITS = 14;
+	static constexpr int GAIN_BITS = 15;
+	static constexpr int GUARD_BITS = 2; // kept through the matrix, so rounding the line gains costs little decay time
+	static constexpr int WET_SHIFT = 2; // off the summed lines (up to 19 bits), so the wet product stays in 32 bits
+
+	// Where each line starts in buffer
+	struct Offsets {
+		uint16_t at[17];
+		constexpr Offsets() : at() {
+			for (int i = 0; i < 16; ++i) {
+				at[i + 1] = at[i] + LENGTHS[i];
+			}
+		}
+	};
+	static constexpr Offsets OFFSETS{};
+
+	int16_t buffer[OFFSETS.at[LINES]];
+	uint16_t pos[LINES];
+	int32_t lowpass[LINES];
+	int32_t gain[LINES]; // Q15 loss per pass through the line, with the matrix's 1 / sqrt(lines)
+	unsigned int lines = LINES;
+
+	int32_t inputState = 0;
+	int32_t bandwidthCoeff; // input lowpass, Q14
+	int32_t dampingCoeff;	// loop lowpass, Q14: share of the old state kept
+	int32_t wetGain;		// Q15, mix / sqrt(lines); the input goes into every line, so any tier is as loud
+	int32_t dryGain;		// Q15, 1 - mix
+	float rt60;
+	float mix;
+
+	void updateGains() {
+		float norm = 1 / sqrtf((float)lines);
+		for (unsigned int i = 0; i < lines; ++i) {
+			float g = powf(10.0f, -3.0f * LENGTHS[i] / (rt60 * AUDIO_RATE)) * norm;
+			gain[i] = (int32_t)(g * ((1 << GAIN_BITS) - 1));
+		}
+		wetGain = (int32_t)(mix * norm * ((1 << GAIN_BITS) - 1));
+		dryGain = (int32_t)((1 - mix) * ((1 << GAIN_BITS) - 1));
+	}
+
+	// Fixed-point products rounded toward zero, so the tail decays all the way to silence instead of settling on a
+	// small offset. Branch-free: the sign of a reverb signal is a coin toss for the branch predictor
+	template <int BITS>
+	static int32_t shiftTowardZero(int32_t x) {
+		return (x + ((x >> 31) & ((1 << BITS) - 1))) >> BITS;
+	}
+
+	template <int BITS = COEFF_BITS>
+	static int32_t scale(int32_t x, int32_t coeff) {
+		return shiftTowardZero<BITS>(x * coeff);
+	}
+
+	template <unsigned int N>
+	static void AUDIO_HOT hadamard(int32_t *v) {
+		for (unsigned int half = 1; half < N; half <<= 1) {
+			for (unsigned int i = 0; i < N; i += 2 * half) {
+				for (unsigned int j = i; j < i + half; ++j) {
+					int32_t a = v[j], b = v[j + half];
+					v[j] = a + b;
+					v[j + half] = a - b;
+				}
+			}
+		}
+	}
+
+	// Copies n samples of line i from p, wrapping, into out; or back from in when write is set
+	void AUDIO_HOT copyLine(unsigned int i, uint32_t p, int16_t *block, size_t n, bool write) {
+		int16_t *line = buffer + OFFSETS.at[i];
+		size_t first = LENGTHS[i] - p < n ? LENGTHS[i] - p : n;
+		if (write) {
+			memcpy(line + p, block, first * sizeof(int16_t));
+			memcpy(line, block + first, (n - first) * sizeof(int16_t));
+		} else {
+			memcpy(block, line + p, first * sizeof(int16_t));
+			memcpy(block + first, line, (n - first) * sizeof(int16_t));
+		}
+	}
+
+	// One loop per tier, so the compiler can unroll the lines and the matrix. Every line is longer than a chunk, so a
+	// chunk's outputs are all in the lines before it starts: they are copied out in runs, mixed in a local block, and
+	// the chunk's inputs copied back, which keeps the ring indexing out of the per-sample loop
+	template <unsigned int N>
+	void AUDIO_HOT renderLines(const int32_t *in, StereoFrame *out, size_t n) {
+		static constexpr size_t CHUNK = 32;
+		static_assert(CHUNK <= LENGTHS[0], "a chunk must fit in the shortest line");
+		int16_t block[N][CHUNK];
+		int32_t lp[N], g[N];
+		for (unsigned int i = 0; i < N; ++i) {
+			lp[i] = lowpass[i];
+			g[i] = gain[i];
+		}
+		int32_t state = inputState;
+		const int32_t band = bandwidthCoeff, damp = dampingCoeff;
+		const int32_t dry = dryGain, wetG = wetGain;
+
+		for (size_t start = 0; start < n; start += CHUNK) {
+			size_t count = n - start < CHUNK ? n - start : CHUNK;
+			for (unsigned int i = 0; i < N; ++i) {
+				copyLine(i, pos[i], block[i], count, false);
+			}
+			for (size_t k = 0; k < count; ++k) {
+				int32_t dryIn = in[start + k];
+				int32_t x = dryIn >> 1; // 15 bits, so the lowpass difference fits the Q14 multiply
+				state += ((x - state) * band) >> COEFF_BITS;
+
+				int32_t v[N];
+				int32_t wetL = 0, wetR = 0;
+				for (unsigned int i = 0; i < N; ++i) {
+					int32_t o = block[i][k];
+					wetL += (i & 1) ? -o : o;
+					wetR += (i & 2) ? -o : o;
+					lp[i] = o + scale(lp[i] - o, damp);
+					v[i] = scale<GAIN_BITS - GUARD_BITS>(lp[i], g[i]); // the loss for the line just passed
+				}
+				hadamard<N>(v);
+				for (unsigned int i = 0; i < N; ++i) {
+					int32_t y = shiftTowardZero<GUARD_BITS>(v[i]) + ((i & 1) ? -state : state);
+					block[i][k] = y > 32767 ? 32767 : (y < -32768 ? -32768 : y);
+				}
+				int32_t d = (dryIn * dry) >> GAIN_BITS;
+				out[start + k].l = d + (((wetL >> WET_SHIFT) * wetG) >> (GAIN_BITS - WET_SHIFT));
+				out[start + k].r = d + (((wetR >> WET_SHIFT) * wetG) >> (GAIN_BITS - WET_SHIFT));
+			}
+			for (unsigned int i = 0; i < N; ++i) {
+				copyLine(i, pos[i], block[i], count, true);
+				pos[i] = pos[i] + count >= LENGTHS[i] ? pos[i] + count - LENGTHS[i] : pos[i] + count;
+			}
+		}
+
+		for (unsigned int i = 0; i < N; ++i) {
+			lowpass[i] = lp[i];
+		}
+		inputState = state;
+	}
+
+  public:
+	// Extra magnitude bits the tail may add on top of its input
+	static constexpr int HEADROOM_BITS = 1;
+
+	// decay, damping, bandwidth and mix as for mPlateReverb, all 0-1 (see the setters)
+	FdnReverb(float decay = 0.6, float damping = 0.8, float bandwidth = 0.3, float mix = 0.5) : mix(mix) {
+		memset(buffer, 0, sizeof(buffer));
+		memset(pos, 0, sizeof(pos));
+		memset(lowpass, 0, sizeof(lowpass));
+		setDamping(damping);
+		setBandwidth(bandwidth);
+		setDecay(decay);
+	}
+
+	// Decay time from 0.2 s at 0 to 10 s at 1, exponentially
+	void setDecay(float decay) { setRt60(0.2f * powf(50.0f, decay)); }
+
+	// Time for the tail to fall by 60 dB, in seconds
+	void setRt60(float seconds) {
+		rt60 = seconds > 0.01f ? seconds : 0.01f;
+		updateGains();
+	}
+
+	float getRt60() { return rt60; }
+
+	// High-frequency loss in the loop: 0 keeps the tail bright, 1 leaves it dull
+	void setDamping(float damping) { dampingCoeff = (int32_t)(0.95f * damping * (1 << COEFF_BITS)); }
+
+	// Input lowpass: 1 lets everything in, lower values darken what enters the tail
+	void setBandwidth(float bandwidth) { bandwidthCoeff = (int32_t)((0.05f + 0.95f * bandwidth) * (1 << COEFF_BITS)); }
+
+	// Wet share of the output, 0-1
+	void setMix(float m) {
+		mix = m;
+		updateGains();
+	}
+
+	// Lines in use: 4, 8 or 16, up to LINES. Lines coming back into use start silent
+	void setLines(unsigned int n) {
+		n = n >= 16 ? 16 : (n >= 8 ? 8 : 4);
+		n = n < LINES ? n : LINES;
+		for (unsigned int i = lines; i < n; ++i) {
+			memset(buffer + OFFSETS.at[i], 0, LENGTHS[i] * sizeof(int16_t));
+			lowpass[i] = 0;
+		}
+		lines = n;
+		updateGains();
+	}
+
+	unsigned int getLines() { return lines; }
+
+	StereoFrame AUDIO_HOT next(int32_t in) {
+		StereoFrame out;
+		render(&in, &out, 1);
+		return out;
+	}
+
+	// Renders n stereo frames into out from n mono samples of in
+	void AUDIO_HOT render(const int32_t *in, StereoFrame *out, size_t n) {
+		if (LINES >= 16 && lines == 16)
+			renderLines<LINES >= 16 ? 16 : LINES>(in, out, n);
+		else if (LINES >= 8 && lines == 8)
+			renderLines<LINES >= 8 ? 8 : LINES>(in, out, n);
+		else
+			renderLines<4>(in, out, n);
+	}
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <atomic>
+#include <stddef.h>
+
+// Lock-free single-producer/single-consumer queue. One thread may push and one other thread may pop; neither ever
+// blocks. CAPACITY must be a power of two, and one slot is always left empty to tell full from empty.
+template <class T, size_t CAPACITY>
+class SpscMailbox {
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+  private:
+	T slots[CAPACITY];
+	std::atomic<size_t> head{0}; // next slot to pop, written by the consumer
+	std::atomic<size_t> tail{0}; // next slot to push, written by the producer
+
+  public:
+	// Producer side. Returns false if the mailbox is full
+	bool push(const T &item) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t next = (t + 1) & (CAPACITY - 1);
+		if (next == head.load(std::memory_order_acquire))
+			return false;
+		slots[t] = item;
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side. Returns false if the mailbox is empty
+	bool pop(T &item) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return false;
+		item = slots[h];
+		head.store((h + 1) & (CAPACITY - 1), std::memory_order_release);
+		return true;
+	}
+};
+
+#endif
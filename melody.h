@@ -1,4 +1,8 @@
 #include "enableable.h"
+#include "mip_tables.h"
+#include "osc_bank.h"
+#include "placement.h"
+#include "voice_pool.h"
 
 #include <Meap.h>
 #include <string>
@@ -16,9 +20,43 @@ class Melody : public mOscil<NUM_CELLS, UPDATE_RATE, T>, public Enableable {
 	int morphVal = 0;  // Store the current morph input value
 	mOscil<NUM_CELLS, UPDATE_RATE, T> osc2;
 
+	// Baked morph: the wave1/wave2 blend is rendered into one of two private BAKED_CELLS tables so audio needs a
+	// single interpolated lookup per sample. The front table plays while the back one is rebaked a slice at a time by
+	// bakeStep()
+	static constexpr unsigned int BAKED_CELLS = NUM_CELLS < 2048 ? NUM_CELLS : 2048;
+	T *bakedTables[2] = {nullptr, nullptr};
+	InterpOscil<BAKED_CELLS, UPDATE_RATE, T> bakedOsc;
+	int bakedFront = 0;
+	int bakeCursor = -1; // next cell of the back table to bake, -1 when idle
+	bool bakeDirty = false;
+	int bakeIdx1 = 0;
+	int bakeIdx2 = 0;
+	int bakeMix = 0;
+
+	// Band-limited levels per table, nullptr for tables without overtones. The level follows the note in setFreq()
+	// and is baked in with the morph, so a note change costs nothing per sample
+	MipTables<NUM_CELLS, UPDATE_RATE, T> *mips[4] = {nullptr, nullptr, nullptr, nullptr};
+	int mipLevel = 0;
+	int bakeLevel = 0;
+	bool bakeUrgent = false;
+
+	bool hasMips() const { return mips[0] || mips[1] || mips[2] || mips[3]; }
+
+	int32_t bakeSample(int idx, unsigned int cell) const {
+		cell *= NUM_CELLS / BAKED_CELLS;
+		return mips[idx] ? mips[idx]->sample(bakeLevel, cell) : (int32_t)tables[idx][cell];
+	}
+
+	bool isBaked() const { return bakedTables[0] != nullptr; }
+
+	bool isMixing() const { return wave2Idx != -1 && !isBaked(); }
+
   public:
+	// Magnitude bound of render() output for the mix bus: |x| <= 2^OUTPUT_BITS
+	static constexpr int OUTPUT_BITS = sizeof(T) * 8 - 1;
+
 	Melody(const T *table_data, std::string name = "Wave")
-		: mOscil<NUM_CELLS, UPDATE_RATE, T>(table_data), osc2(table_data) {
+		: mOscil<NUM_CELLS, UPDATE_RATE, T>(table_data), osc2(table_data), bakedOsc(table_data) {
 		tables[0] = table_data;
 		tableNames[0] = name;
 		tableCount = 1;
@@ -34,19 +72,86 @@ class Melody : public mOscil<NUM_CELLS, UPDATE_RATE, T>, public Enableable {
 
 	void setWave1(int index) {
 		if (index >= 0 && index < tableCount) {
+			bakeDirty |= index != wave1Idx;
 			wave1Idx = index;
-			this->setTable(tables[index]);
+			if (!isBaked())
+				this->setTable(tables[index]);
 		}
 	}
 
 	void setWave2(int index) {
 		if (index >= 0 && index < tableCount) {
+			bakeDirty |= index != wave2Idx;
 			wave2Idx = index;
 			osc2.setTable(tables[index]);
 		}
 	}
 
-	void setMix(int mix) { mixVal = mix; }
+	void setMix(int mix) {
+		bakeDirty |= mix != mixVal;
+		mixVal = mix;
+	}
+
+	// Switches to baked morph mode, allocating two BAKED_CELLS scratch tables and baking the current blend right away.
+	// From then on morph changes reach the output through bakeStep()
+	void enableBakedMorph() {
+		if (isBaked())
+			return;
+		bakedTables[0] = new T[BAKED_CELLS];
+		bakedTables[1] = new T[BAKED_CELLS];
+		bakeDirty = true;
+		bakeStep(BAKED_CELLS);
+	}
+
+	// Builds band-limited levels for every table added so far; they take effect through the baked morph. Call after
+	// the last addTable(), before enableBakedMorph()
+	void enableMipmaps() {
+		for (int i = 0; i < tableCount; ++i) {
+			if (mips[i])
+				continue;
+			mips[i] = new MipTables<NUM_CELLS, UPDATE_RATE, T>();
+			if (!mips[i]->build(tables[i])) {
+				delete mips[i];
+				mips[i] = nullptr;
+			}
+		}
+	}
+
+	// Bakes up to cells cells of a pending morph change into the back table and swaps it in once complete. A change
+	// of mip level is baked whole on the next call so a new note doesn't play the wrong octave's table for long.
+	// Call once per control tick from the thread that renders this melody
+	void bakeStep(unsigned int cells = BAKED_CELLS / 8) {
+		if (!isBaked())
+			return;
+		if (bakeCursor < 0) {
+			if (!bakeDirty)
+				return;
+			// Later changes wait for this bake to finish, so a moving pot still updates every few ticks
+			bakeDirty = false;
+			bakeIdx1 = wave1Idx;
+			bakeIdx2 = (wave2Idx != -1) ? wave2Idx : wave1Idx;
+			bakeMix = mixVal;
+			bakeLevel = mipLevel;
+			bakeCursor = 0;
+		}
+		if (bakeUrgent) {
+			bakeUrgent = false;
+			cells = BAKED_CELLS;
+		}
+
+		T *back = bakedTables[1 - bakedFront];
+		unsigned int end = bakeCursor + cells < BAKED_CELLS ? bakeCursor + cells : BAKED_CELLS;
+		for (unsigned int i = bakeCursor; i < end; ++i) {
+			back[i] = (T)((bakeSample(bakeIdx1, i) * (4095 - bakeMix) + bakeSample(bakeIdx2, i) * bakeMix) >> 12);
+		}
+		bakeCursor = end;
+
+		if (bakeCursor == (int)BAKED_CELLS) {
+			bakedFront = 1 - bakedFront;
+			bakedOsc.setTable(bakedTables[bakedFront]);
+			bakeCursor = -1;
+		}
+	}
 
 	int getMix() { return mixVal; }
 
@@ -65,28 +170,29 @@ class Melody : public mOscil<NUM_CELLS, UPDATE_RATE, T>, public Enableable {
 		if (tableCount < 2)
 			return; // Need at least 2 tables to mix
 
+		int idx1, idx2, mix;
+		morphPoint(val, idx1, idx2, mix);
+		setWave1(idx1);
+		setWave2(idx2);
+		setMix(mix);
+	}
+
+	// Tables and mix a morph input selects. Segments run Table 0 -> 1, 1 -> 2, 2 -> 3; with fewer tables the
+	// segment sticks to the last one
+	void morphPoint(int val, int &idx1, int &idx2, int &mix) const {
+		int segment;
 		if (val < 1365) {
-			// Segment 1: Table 0 -> Table 1
-			setWave1(0);
-			if (tableCount > 1)
-				setWave2(1);
-			setMix(map(val, 0, 1365, 0, 4095));
+			segment = 0;
+			mix = map(val, 0, 1365, 0, 4095);
 		} else if (val < 2730) {
-			// Segment 2: Table 1 -> Table 2
-			// If we don't have enough tables, stick to the last one
-			if (tableCount > 1)
-				setWave1(1);
-			if (tableCount > 2)
-				setWave2(2);
-			setMix(map(val, 1366, 2730, 0, 4095));
+			segment = 1;
+			mix = map(val, 1366, 2730, 0, 4095);
 		} else {
-			// Segment 3: Table 2 -> Table 3
-			if (tableCount > 2)
-				setWave1(2);
-			if (tableCount > 3)
-				setWave2(3);
-			setMix(map(val, 2731, 4095, 0, 4095));
+			segment = 2;
+			mix = map(val, 2731, 4095, 0, 4095);
 		}
+		idx1 = segment < tableCount ? segment : tableCount - 1;
+		idx2 = segment + 1 < tableCount ? segment + 1 : tableCount - 1;
 	}
 
 	int getMorph() { return morphVal; }
@@ -103,16 +209,40 @@ class Melody : public mOscil<NUM_CELLS, UPDATE_RATE, T>, public Enableable {
 		return statusString.c_str();
 	}
 
+	// Describes the tables a morph input selects without changing the oscillator, so the control side can report a
+	// morph the audio side owns
+	const char *getMorphStatus(int val) {
+		if (tableCount < 2)
+			return tableNames[0].c_str(); // Fallback if no second table
+
+		int idx1, idx2, mix;
+		morphPoint(val, idx1, idx2, mix);
+		statusString = tableNames[idx1] + "->" + tableNames[idx2];
+		return statusString.c_str();
+	}
+
 	void setFreq(float freq) {
 		mOscil<NUM_CELLS, UPDATE_RATE, T>::setFreq(freq);
 		osc2.setFreq(freq);
+		bakedOsc.setFreq(freq);
+
+		int level = MipTables<NUM_CELLS, UPDATE_RATE, T>::levelFor(freq);
+		if (level != mipLevel && hasMips()) {
+			mipLevel = level;
+			// Restart any bake in progress from scratch at the new level
+			bakeCursor = -1;
+			bakeDirty = true;
+			bakeUrgent = true;
+		}
 	}
 
-	T next() {
+	T AUDIO_HOT next() {
 		if (Enableable::isEnabled()) { // Explicitly qualify isEnabled
+			if (isBaked())
+				return (T)((bakedOsc.next() * volume) >> 12);
 			T out1 = mOscil<NUM_CELLS, UPDATE_RATE, T>::next();
 			int32_t mixedOutput;
-			if (wave2Idx != -1) {
+			if (isMixing()) {
 				T out2 = osc2.next();
 				// Mix logic: (out1 * (4095 - mix)) + (out2 * mix) >> 12
 				mixedOutput = ((int32_t)out1 * (4095 - mixVal) + (int32_t)out2 * mixVal) >> 12;
@@ -124,4 +254,52 @@ class Melody : public mOscil<NUM_CELLS, UPDATE_RATE, T>, public Enableable {
 		}
 		return 0;
 	}
+
+	// Renders n samples into buf, overwriting it. The enable and morph checks happen once per block
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		if (!Enableable::isEnabled()) {
+			memset(buf, 0, n * sizeof(int32_t));
+			return;
+		}
+		if (isBaked()) {
+			for (size_t i = 0; i < n; ++i) {
+				buf[i] = (bakedOsc.next() * volume) >> 12;
+			}
+		} else if (isMixing()) {
+			for (size_t i = 0; i < n; ++i) {
+				int32_t out1 = mOscil<NUM_CELLS, UPDATE_RATE, T>::next();
+				int32_t out2 = osc2.next();
+				int32_t mixedOutput = (out1 * (4095 - mixVal) + out2 * mixVal) >> 12;
+				buf[i] = (mixedOutput * volume) >> 12;
+			}
+		} else {
+			for (size_t i = 0; i < n; ++i) {
+				buf[i] = ((int32_t)mOscil<NUM_CELLS, UPDATE_RATE, T>::next() * volume) >> 12;
+			}
+		}
+	}
+};
+
+// Plain melody line on a voice pool: each new note releases the previous one, which rings out under it instead of
+// being cut off
+template <unsigned int MAX_VOICES, unsigned int NUM_CELLS, unsigned int UPDATE_RATE, class T = int16_t,
+		  bool INTERPOLATE = false>
+class PolyMelody : public VoicePool<MAX_VOICES, NUM_CELLS, UPDATE_RATE, T, INTERPOLATE>, public Enableable {
+  public:
+	PolyMelody(const T *table_data, unsigned int attackMs = 5, unsigned int releaseMs = 250)
+		: VoicePool<MAX_VOICES, NUM_CELLS, UPDATE_RATE, T, INTERPOLATE>(table_data, attackMs, releaseMs) {}
+
+	void play(int midiNote) {
+		this->releaseAll();
+		this->noteOn(midiNote);
+	}
+
+	// Renders n samples into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		if (!Enableable::isEnabled()) {
+			memset(buf, 0, n * sizeof(int32_t));
+			return;
+		}
+		VoicePool<MAX_VOICES, NUM_CELLS, UPDATE_RATE, T, INTERPOLATE>::render(buf, n);
+	}
 };
@@ -0,0 +1,126 @@
+#ifndef MIP_TABLES_H
+#define MIP_TABLES_H
+
+#include "tables/sin8192_int16.h"
+#include <Meap.h>
+
+// Per-octave band-limited copies of one NUM_CELLS wavetable, built at startup. The source is analysed into its first
+// harmonics once, then every level is resynthesised from the sine table with only the harmonics that stay below
+// Nyquist up to the top of its octave: level 0 covers notes up to LEVEL_0_TOP Hz, each further level an octave more.
+// A level holds 8 cells per harmonic (at least 256), so a whole set takes a little over half the memory of one
+// 8192-cell table, and sample() reads it back at NUM_CELLS resolution with linear interpolation.
+template <unsigned int NUM_CELLS, unsigned int UPDATE_RATE, class T = int16_t>
+class MipTables {
+  public:
+	static constexpr int LEVELS = 8;
+	static constexpr unsigned int LEVEL_0_TOP = 64;
+
+  private:
+	static constexpr unsigned int SINE_CELLS = sin8192_int16_NUM_CELLS;
+	static constexpr unsigned int MAX_HARMONICS = UPDATE_RATE / 2 / LEVEL_0_TOP;
+	static constexpr unsigned int CELLS_PER_HARMONIC = 8;
+	static constexpr unsigned int MIN_CELLS = 256;
+
+	T *levels[LEVELS] = {};
+	unsigned int cellShift[LEVELS] = {}; // log2(NUM_CELLS / level size)
+
+	static constexpr unsigned int harmonicsAt(int level) { return MAX_HARMONICS >> level; }
+
+	static constexpr unsigned int cellsAt(int level) {
+		unsigned int cells = harmonicsAt(level) * CELLS_PER_HARMONIC;
+		return cells < MIN_CELLS ? MIN_CELLS : cells;
+	}
+
+	static int32_t sine(uint32_t index) { return sin8192_int16_DATA[index & (SINE_CELLS - 1)]; }
+
+  public:
+	~MipTables() {
+		for (int level = 0; level < LEVELS; ++level) {
+			delete[] levels[level];
+		}
+	}
+
+	// Level whose octave contains freq; notes above the last octave use the last level
+	static int levelFor(float freq) {
+		int level = 0;
+		while (level < LEVELS - 1 && freq > (float)(LEVEL_0_TOP << level)) {
+			++level;
+		}
+		return level;
+	}
+
+	// Analyses source and builds every level. Returns false, allocating nothing, for a table with no overtones to
+	// band-limit (a sine)
+	bool build(const T *source) {
+		static_assert(NUM_CELLS <= SINE_CELLS && SINE_CELLS % NUM_CELLS == 0, "source must divide the sine table");
+		static_assert(MAX_HARMONICS * CELLS_PER_HARMONIC <= NUM_CELLS, "level 0 must not be larger than the source");
+		const unsigned int quarter = SINE_CELLS / 4;
+		const float limit = (float)((1L << (sizeof(T) * 8 - 1)) - 1);
+
+		// Amplitude of each harmonic's cosine and sine part, in source units
+		float cosines[MAX_HARMONICS + 1];
+		float sines[MAX_HARMONICS + 1];
+		float overtones = 0;
+		for (unsigned int h = 0; h <= MAX_HARMONICS; ++h) {
+			int64_t c = 0, s = 0;
+			for (unsigned int i = 0; i < NUM_CELLS; ++i) {
+				uint32_t index = h * i * (SINE_CELLS / NUM_CELLS);
+				c += (int64_t)source[i] * sine(index + quarter);
+				s += (int64_t)source[i] * sine(index);
+			}
+			float scale = (h == 0 ? 1.0f : 2.0f) / ((float)NUM_CELLS * 32767.0f);
+			cosines[h] = c * scale;
+			sines[h] = h == 0 ? 0 : s * scale;
+			if (h >= 2)
+				overtones += fabsf(cosines[h]) + fabsf(sines[h]);
+		}
+		if (overtones < 0.001f * (fabsf(cosines[1]) + fabsf(sines[1])))
+			return false;
+
+		// One gain for all levels keeps the octaves equally loud, set so the level with the most Gibbs overshoot fits T
+		float *waves[LEVELS];
+		float peak = 0;
+		for (int level = 0; level < LEVELS; ++level) {
+			unsigned int cells = cellsAt(level);
+			waves[level] = new float[cells];
+			for (unsigned int j = 0; j < cells; ++j) {
+				float x = cosines[0];
+				for (unsigned int h = 1; h <= harmonicsAt(level); ++h) {
+					uint32_t index = h * j * (SINE_CELLS / cells);
+					x += (cosines[h] * sine(index + quarter) + sines[h] * sine(index)) / 32767.0f;
+				}
+				waves[level][j] = x;
+				peak = fabsf(x) > peak ? fabsf(x) : peak;
+			}
+		}
+		float gain = peak > limit ? limit / peak : 1.0f;
+
+		for (int level = 0; level < LEVELS; ++level) {
+			unsigned int cells = cellsAt(level);
+			levels[level] = new T[cells];
+			while ((cells << cellShift[level]) < NUM_CELLS) {
+				++cellShift[level];
+			}
+			for (unsigned int j = 0; j < cells; ++j) {
+				float x = waves[level][j] * gain;
+				levels[level][j] = (T)(x > limit ? limit : (x < -limit ? -limit : x)); // float rounding can step past
+			}
+			delete[] waves[level];
+		}
+		return true;
+	}
+
+	// Cell of a level read at NUM_CELLS resolution
+	int32_t sample(int level, unsigned int cell) const {
+		const T *table = levels[level];
+		unsigned int shift = cellShift[level];
+		unsigned int mask = (NUM_CELLS >> shift) - 1;
+		unsigned int j = cell >> shift;
+		int32_t a = table[j];
+		int32_t b = table[(j + 1) & mask];
+		int32_t frac = cell & ((1u << shift) - 1);
+		return a + (((b - a) * frac) >> shift);
+	}
+};
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef MIX_BUS_H
+#define MIX_BUS_H
+
+#include "stereo.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-point mix bus that proves at compile time that every gain stage and the summed bus fit in int32.
+// Bit counts are magnitude bounds: a signal of BITS bits satisfies |x| <= 2^BITS.
+
+namespace MixBusDetail {
+constexpr int ceilLog2(int64_t x) {
+	int bits = 0;
+	while ((int64_t(1) << bits) < x)
+		++bits;
+	return bits;
+}
+
+template <int SHIFT> inline int32_t shift(int32_t x) {
+	if constexpr (SHIFT >= 0) {
+		return x << SHIFT;
+	} else {
+		return x >> -SHIFT;
+	}
+}
+} // namespace MixBusDetail
+
+// One bus input: a source of SOURCE_BITS, multiplied by a gain below 2^GAIN_BITS, then shifted by SHIFT
+// (positive = left). Sources without a runtime gain use GAIN_BITS = 0.
+template <int SOURCE_BITS, int GAIN_BITS = 0, int SHIFT = 0>
+struct GainStage {
+	static_assert(SOURCE_BITS + GAIN_BITS + (SHIFT > 0 ? SHIFT : 0) <= 31, "gain stage overflows int32");
+	static_assert(SOURCE_BITS + GAIN_BITS + SHIFT >= 0, "gain stage shifts the signal away entirely");
+
+	static constexpr int OUTPUT_BITS = SOURCE_BITS + GAIN_BITS + SHIFT;
+
+	// bus[i] += src[i] << SHIFT
+	static void mix(int32_t *bus, const int32_t *src, size_t n) {
+		static_assert(GAIN_BITS == 0, "this stage needs a gain");
+		for (size_t i = 0; i < n; ++i) {
+			bus[i] += MixBusDetail::shift<SHIFT>(src[i]);
+		}
+	}
+
+	// bus[i] += (src[i] * gain) << SHIFT, gain in [0, 2^GAIN_BITS)
+	static void mix(int32_t *bus, const int32_t *src, size_t n, int32_t gain) {
+		static_assert(GAIN_BITS > 0, "this stage has no gain");
+		for (size_t i = 0; i < n; ++i) {
+			bus[i] += MixBusDetail::shift<SHIFT>(src[i] * gain);
+		}
+	}
+
+	// Like mix(), also adding the stage's output at a send level to SEND's bus
+	template <class SEND>
+	static void mix(int32_t *bus, int32_t *send, const int32_t *src, size_t n, int32_t level) {
+		static_assert(GAIN_BITS == 0, "this stage needs a gain");
+		for (size_t i = 0; i < n; ++i) {
+			int32_t y = MixBusDetail::shift<SHIFT>(src[i]);
+			bus[i] += y;
+			send[i] += MixBusDetail::shift<SEND::template SHIFT<OUTPUT_BITS>>(y * level);
+		}
+	}
+
+	template <class SEND>
+	static void mix(int32_t *bus, int32_t *send, const int32_t *src, size_t n, int32_t gain, int32_t level) {
+		static_assert(GAIN_BITS > 0, "this stage has no gain");
+		for (size_t i = 0; i < n; ++i) {
+			int32_t y = MixBusDetail::shift<SHIFT>(src[i] * gain);
+			bus[i] += y;
+			send[i] += MixBusDetail::shift<SEND::template SHIFT<OUTPUT_BITS>>(y * level);
+		}
+	}
+
+	// Stereo bus: the mono source is panned onto both channels. The send takes it before the pan
+	static void mix(StereoFrame *bus, const int32_t *src, size_t n, Pan pan) {
+		static_assert(GAIN_BITS == 0, "this stage needs a gain");
+		for (size_t i = 0; i < n; ++i) {
+			addPanned(bus[i], MixBusDetail::shift<SHIFT>(src[i]), pan);
+		}
+	}
+
+	static void mix(StereoFrame *bus, const int32_t *src, size_t n, int32_t gain, Pan pan) {
+		static_assert(GAIN_BITS > 0, "this stage has no gain");
+		for (size_t i = 0; i < n; ++i) {
+			addPanned(bus[i], MixBusDetail::shift<SHIFT>(src[i] * gain), pan);
+		}
+	}
+
+	template <class SEND>
+	static void mix(StereoFrame *bus, int32_t *send, const int32_t *src, size_t n, int32_t level, Pan pan) {
+		static_assert(GAIN_BITS == 0, "this stage needs a gain");
+		for (size_t i = 0; i < n; ++i) {
+			int32_t y = MixBusDetail::shift<SHIFT>(src[i]);
+			addPanned(bus[i], y, pan);
+			send[i] += MixBusDetail::shift<SEND::template SHIFT<OUTPUT_BITS>>(y * level);
+		}
+	}
+
+	template <class SEND>
+	static void mix(StereoFrame *bus, int32_t *send, const int32_t *src, size_t n, int32_t gain, int32_t level,
+					Pan pan) {
+		static_assert(GAIN_BITS > 0, "this stage has no gain");
+		for (size_t i = 0; i < n; ++i) {
+			int32_t y = MixBusDetail::shift<SHIFT>(src[i] * gain);
+			addPanned(bus[i], y, pan);
+			send[i] += MixBusDetail::shift<SEND::template SHIFT<OUTPUT_BITS>>(y * level);
+		}
+	}
+
+	// Stereo source, SOURCE_BITS per channel. The send takes the mono sum
+	static void mix(StereoFrame *bus, const StereoFrame *src, size_t n) {
+		static_assert(GAIN_BITS == 0, "this stage needs a gain");
+		for (size_t i = 0; i < n; ++i) {
+			bus[i].l += MixBusDetail::shift<SHIFT>(src[i].l);
+			bus[i].r += MixBusDetail::shift<SHIFT>(src[i].r);
+		}
+	}
+
+	static void mix(StereoFrame *bus, const StereoFrame *src, size_t n, int32_t gain) {
+		static_assert(GAIN_BITS > 0, "this stage has no gain");
+		for (size_t i = 0; i < n; ++i) {
+			bus[i].l += MixBusDetail::shift<SHIFT>(src[i].l * gain);
+			bus[i].r += MixBusDetail::shift<SHIFT>(src[i].r * gain);
+		}
+	}
+
+	template <class SEND>
+	static void mix(StereoFrame *bus, int32_t *send, const StereoFrame *src, size_t n, int32_t level) {
+		static_assert(GAIN_BITS == 0, "this stage needs a gain");
+		for (size_t i = 0; i < n; ++i) {
+			StereoFrame y = {MixBusDetail::shift<SHIFT>(src[i].l), MixBusDetail::shift<SHIFT>(src[i].r)};
+			bus[i] = bus[i] + y;
+			send[i] += MixBusDetail::shift<SEND::template SHIFT<OUTPUT_BITS>>(y.mid() * level);
+		}
+	}
+
+  private:
+	static void addPanned(StereoFrame &frame, int32_t y, Pan pan) {
+		static_assert(OUTPUT_BITS + Pan::BITS < 31, "panning overflows int32");
+		frame = frame + pan.place(y);
+	}
+};
+
+// Effect send bus fed by STAGES through GainStage::mix<SendBus>(). A send level below 2^LEVEL_BITS scales each
+// stage so that a full-scale stage at full send reaches 2^BITS, and clamp() holds the sum there before the effect:
+// the effect's input bound doesn't grow with the number of senders, and clipping needs several loud sends at once.
+template <int BITS, int LEVEL_BITS, class... STAGES>
+struct SendBus {
+	static_assert((int64_t(sizeof...(STAGES)) << BITS) < (int64_t(1) << 31), "send bus sum overflows int32");
+	static_assert(((STAGES::OUTPUT_BITS + LEVEL_BITS <= 31) && ...), "send level overflows int32");
+
+	static constexpr int OUTPUT_BITS = BITS;
+
+	template <int STAGE_BITS>
+	static constexpr int SHIFT = BITS - STAGE_BITS - LEVEL_BITS;
+
+	static void clamp(int32_t *send, size_t n) {
+		const int32_t limit = int32_t(1) << BITS;
+		for (size_t i = 0; i < n; ++i) {
+			send[i] = send[i] > limit ? limit : (send[i] < -limit ? -limit : send[i]);
+		}
+	}
+};
+
+// Sum of STAGES followed by a master gain below 2^MASTER_GAIN_BITS, producing at most OUTPUT_BITS (plus sign).
+// The bus is pre-shifted just enough for the master multiply to stay in int32.
+template <int OUTPUT_BITS, int MASTER_GAIN_BITS, class... STAGES>
+struct MixBus {
+	static constexpr int64_t PEAK = ((int64_t(1) << STAGES::OUTPUT_BITS) + ...);
+	static constexpr int SUM_BITS = MixBusDetail::ceilLog2(PEAK);
+	static constexpr int PRE_SHIFT = SUM_BITS + MASTER_GAIN_BITS > 31 ? SUM_BITS + MASTER_GAIN_BITS - 31 : 0;
+
+	static_assert(PEAK < (int64_t(1) << 31), "mix bus sum overflows int32");
+	static_assert(PRE_SHIFT <= MASTER_GAIN_BITS, "mix bus too hot for the master gain");
+	static_assert(SUM_BITS <= OUTPUT_BITS, "mix bus exceeds the output width");
+
+	// bus[i] = bus[i] * gain / 2^MASTER_GAIN_BITS, gain in [0, 2^MASTER_GAIN_BITS)
+	static void master(int32_t *bus, size_t n, int32_t gain) {
+		for (size_t i = 0; i < n; ++i) {
+			bus[i] = ((bus[i] >> PRE_SHIFT) * gain) >> (MASTER_GAIN_BITS - PRE_SHIFT);
+		}
+	}
+
+	// Both channels of a stereo bus, each bounded like the mono bus
+	static void master(StereoFrame *bus, size_t n, int32_t gain) {
+		for (size_t i = 0; i < n; ++i) {
+			bus[i].l = ((bus[i].l >> PRE_SHIFT) * gain) >> (MASTER_GAIN_BITS - PRE_SHIFT);
+			bus[i].r = ((bus[i].r >> PRE_SHIFT) * gain) >> (MASTER_GAIN_BITS - PRE_SHIFT);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef OSC_BANK_H
+#define OSC_BANK_H
+
+#include "placement.h"
+
+#include <Meap.h>
+
+constexpr int oscLog2(unsigned int x) { return x <= 1 ? 0 : 1 + oscLog2(x >> 1); }
+
+// Fraction bits for interpolating between cells; 14 keeps (b - a) * frac within int32 for int16 tables
+constexpr int INTERP_FRAC_BITS = 14;
+
+// Linearly interpolated read of a NUM_CELLS table at a 32-bit phase
+template <unsigned int NUM_CELLS, class T>
+inline int32_t interpolateCell(const T *table, uint32_t phase) {
+	constexpr int INDEX_SHIFT = 32 - oscLog2(NUM_CELLS);
+	uint32_t index = phase >> INDEX_SHIFT;
+	int32_t a = table[index];
+	int32_t b = table[(index + 1) & (NUM_CELLS - 1)];
+	int32_t frac = (phase >> (INDEX_SHIFT - INTERP_FRAC_BITS)) & ((1 << INTERP_FRAC_BITS) - 1);
+	return a + (((b - a) * frac) >> INTERP_FRAC_BITS);
+}
+
+// Single wavetable oscillator that interpolates between cells. A 1024 or 2048-cell table read this way is cleaner
+// than a truncated 8192-cell one and small enough to sit in RAM instead of behind the flash cache
+template <unsigned int NUM_CELLS, unsigned int UPDATE_RATE, class T = int16_t>
+class InterpOscil {
+	static_assert((NUM_CELLS & (NUM_CELLS - 1)) == 0, "table size must be a power of two");
+
+  private:
+	const T *table;
+	uint32_t phase = 0;
+	uint32_t increment = 0;
+
+  public:
+	InterpOscil(const T *table_data) : table(table_data) {}
+
+	void setTable(const T *table_data) { table = table_data; }
+
+	void setFreq(float freq) { increment = (uint32_t)(freq * (4294967296.0f / UPDATE_RATE)); }
+
+	void setPhase(uint32_t newPhase = 0) { phase = newPhase; }
+
+	int32_t AUDIO_HOT next() {
+		phase += increment;
+		return interpolateCell<NUM_CELLS>(table, phase);
+	}
+};
+
+// Bank of LANES wavetable oscillators sharing one table, stepped together and summed into a single output. Phases are
+// 32-bit accumulators whose top bits index the table. With GCC the phases advance four lanes at a time as 128-bit
+// vector operations (SSE/NEON on a host, scalar code generated by the compiler on targets without SIMD), so more lanes
+// only add more vector groups; define OSC_BANK_SCALAR or build with another compiler for the plain per-lane loop.
+// Each lane carries its own gain, so a bank can host enveloped voices as well as a fixed chord. With INTERPOLATE the
+// lanes read between cells like InterpOscil, for small RAM tables.
+template <unsigned int LANES, unsigned int NUM_CELLS, unsigned int UPDATE_RATE, class T = int16_t,
+		  bool INTERPOLATE = false>
+class OscBank {
+	static_assert(LANES % 4 == 0, "lanes come in groups of four");
+	static_assert((NUM_CELLS & (NUM_CELLS - 1)) == 0, "table size must be a power of two");
+
+  private:
+	static constexpr int INDEX_SHIFT = 32 - oscLog2(NUM_CELLS);
+	static constexpr unsigned int GROUPS = LANES / 4;
+
+	const T *table;
+
+#if defined(__GNUC__) && !defined(OSC_BANK_SCALAR)
+	typedef uint32_t PhaseVector __attribute__((vector_size(4 * sizeof(uint32_t))));
+	typedef int32_t GainVector __attribute__((vector_size(4 * sizeof(int32_t))));
+	PhaseVector phases[GROUPS] = {};
+	PhaseVector increments[GROUPS] = {};
+	GainVector gains[GROUPS];
+	GainVector gainSteps[GROUPS] = {};
+	GainVector gainTargets[GROUPS];
+
+	int32_t step() {
+		int32_t sum = 0;
+		for (unsigned int group = 0; group < GROUPS; ++group) {
+			phases[group] += increments[group];
+			gains[group] += gainSteps[group];
+			PhaseVector indices = phases[group] >> INDEX_SHIFT;
+			GainVector samples = {table[indices[0]], table[indices[1]], table[indices[2]], table[indices[3]]};
+			if constexpr (INTERPOLATE) {
+				PhaseVector nexts = (indices + 1) & (NUM_CELLS - 1);
+				GainVector following = {table[nexts[0]], table[nexts[1]], table[nexts[2]], table[nexts[3]]};
+				GainVector fracs = (GainVector)((phases[group] >> (INDEX_SHIFT - INTERP_FRAC_BITS)) &
+												((1 << INTERP_FRAC_BITS) - 1));
+				samples += ((following - samples) * fracs) >> INTERP_FRAC_BITS;
+			}
+			GainVector weighted = (samples * gains[group]) >> GAIN_BITS;
+			sum += weighted[0] + weighted[1] + weighted[2] + weighted[3];
+		}
+		return sum;
+	}
+
+	void setIncrement(unsigned int lane, uint32_t increment) { increments[lane / 4][lane % 4] = increment; }
+	void setPhaseAt(unsigned int lane, uint32_t phase) { phases[lane / 4][lane % 4] = phase; }
+	void setGainTarget(unsigned int lane, int32_t gain) { gainTargets[lane / 4][lane % 4] = gain; }
+
+	void beginRamp(size_t n) {
+		for (unsigned int group = 0; group < GROUPS; ++group) {
+			gainSteps[group] = (gainTargets[group] - gains[group]) / (int32_t)n;
+		}
+	}
+
+	void endRamp() {
+		for (unsigned int group = 0; group < GROUPS; ++group) {
+			gains[group] = gainTargets[group];
+			gainSteps[group] = GainVector{};
+		}
+	}
+#else
+	uint32_t phases[LANES] = {};
+	uint32_t increments[LANES] = {};
+	int32_t gains[LANES];
+	int32_t gainSteps[LANES] = {};
+	int32_t gainTargets[LANES];
+
+	int32_t step() {
+		int32_t sum = 0;
+		for (unsigned int lane = 0; lane < LANES; ++lane) {
+			phases[lane] += increments[lane];
+			gains[lane] += gainSteps[lane];
+			int32_t sample = INTERPOLATE ? interpolateCell<NUM_CELLS>(table, phases[lane])
+										 : (int32_t)table[phases[lane] >> INDEX_SHIFT];
+			sum += (sample * gains[lane]) >> GAIN_BITS;
+		}
+		return sum;
+	}
+
+	void setIncrement(unsigned int lane, uint32_t increment) { increments[lane] = increment; }
+	void setPhaseAt(unsigned int lane, uint32_t phase) { phases[lane] = phase; }
+	void setGainTarget(unsigned int lane, int32_t gain) { gainTargets[lane] = gain; }
+
+	void beginRamp(size_t n) {
+		for (unsigned int lane = 0; lane < LANES; ++lane) {
+			gainSteps[lane] = (gainTargets[lane] - gains[lane]) / (int32_t)n;
+		}
+	}
+
+	void endRamp() {
+		for (unsigned int lane = 0; lane < LANES; ++lane) {
+			gains[lane] = gainTargets[lane];
+			gainSteps[lane] = 0;
+		}
+	}
+#endif
+
+  public:
+	// Magnitude bound of the summed output for the mix bus: |x| <= 2^OUTPUT_BITS
+	static constexpr int OUTPUT_BITS = sizeof(T) * 8 - 1 + oscLog2(LANES);
+
+	// Lane gains are Q15, so UNITY_GAIN leaves a lane at full level
+	static constexpr int GAIN_BITS = 15;
+	static constexpr int32_t UNITY_GAIN = 1 << GAIN_BITS;
+
+	OscBank(const T *table_data) : table(table_data) {
+		for (unsigned int lane = 0; lane < LANES; ++lane) {
+			setGainTarget(lane, UNITY_GAIN);
+		}
+		endRamp();
+	}
+
+	void setTable(const T *table_data) { table = table_data; }
+
+	void setFreq(unsigned int lane, float freq) {
+		if (lane < LANES)
+			setIncrement(lane, (uint32_t)(freq * (4294967296.0f / UPDATE_RATE)));
+	}
+
+	// Restarts a lane's cycle, e.g. at zero crossing for a new note
+	void setPhase(unsigned int lane, uint32_t phase = 0) {
+		if (lane < LANES)
+			setPhaseAt(lane, phase);
+	}
+
+	// Sets the level a lane reaches by the end of the next render(); the gain ramps linearly across that block so
+	// envelopes move without zipper noise. next() alone jumps straight to it
+	void setGain(unsigned int lane, int32_t gain) {
+		if (lane < LANES)
+			setGainTarget(lane, constrain(gain, 0, UNITY_GAIN));
+	}
+
+	int32_t next() {
+		endRamp();
+		return step();
+	}
+
+	// Renders the gain-weighted sum of all lanes for n samples into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		if (n == 0)
+			return;
+		beginRamp(n);
+		for (size_t i = 0; i < n; ++i) {
+			buf[i] = step();
+		}
+		endRamp();
+	}
+};
+
+#endif
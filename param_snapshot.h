@@ -0,0 +1,45 @@
+#ifndef PARAM_SNAPSHOT_H
+#define PARAM_SNAPSHOT_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Versioned snapshot of a parameter block, handed from one writer to one reader without locks or torn reads.
+// Triple buffered: the writer fills its back buffer and swaps it into the middle slot, the reader swaps the middle
+// slot for its front buffer when a newer version is waiting. Neither side ever waits for the other.
+template <class T>
+class ParamSnapshot {
+  private:
+	static const uint8_t INDEX_MASK = 0x3;
+	static const uint8_t FRESH = 0x4; // middle slot holds a version the reader hasn't taken yet
+
+	T buffers[3];
+	uint32_t versions[3] = {0, 0, 0};
+	std::atomic<uint8_t> middle{1};
+	uint8_t back = 0;  // owned by the writer
+	uint8_t front = 2; // owned by the reader
+	uint32_t nextVersion = 1;
+
+  public:
+	// Writer side: makes value the latest version
+	void publish(const T &value) {
+		buffers[back] = value;
+		versions[back] = nextVersion++;
+		back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// Reader side: moves to the latest published version. Returns false if there was nothing newer
+	bool fetch() {
+		if (!(middle.load(std::memory_order_acquire) & FRESH))
+			return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	// Reader side: the version taken by the last successful fetch()
+	const T &current() const { return buffers[front]; }
+
+	uint32_t currentVersion() const { return versions[front]; }
+};
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Opt-in timing of the stages in renderBlock(). Define AUDIO_PERF as 1 before including to turn it on; otherwise
+// every call below compiles to nothing. The tick counter itself is always there, for cheap whole-block timing.
+#ifndef AUDIO_PERF
+#define AUDIO_PERF 0
+#endif
+
+enum PerfStage {
+	PERF_MELODY,
+	PERF_MELODY_FX, // the melody's panning and its effect chain, timed as one since the chain runs fused
+	PERF_REVERB,
+	PERF_MELODY_2,
+	PERF_CHORD,
+	PERF_DRUMS,
+	PERF_ANNOUNCEMENT,
+	PERF_WIND,
+	PERF_OUTPUT,
+	PERF_STAGE_COUNT
+};
+
+#if defined(ESP32)
+// CPU cycle counter
+inline uint32_t perfTicks() { return ESP.getCycleCount(); }
+inline uint32_t perfTicksPerMicro() { return ESP.getCpuFreqMHz(); }
+#else
+#include <time.h>
+// Host builds count nanoseconds
+inline uint32_t perfTicks() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+inline uint32_t perfTicksPerMicro() { return 1000; }
+#endif
+
+inline const char *perfStageName(int stage) {
+	static const char *names[PERF_STAGE_COUNT] = {"mel", "fx", "rev", "mel2", "chd", "drm", "smp", "wnd", "out"};
+	return names[stage];
+}
+
+#if AUDIO_PERF
+
+// Log-linear histogram of tick counts: four buckets per power of two, so percentiles are within 25%
+class PerfHistogram {
+  private:
+	static const int SUB_BUCKETS = 4;
+	static const int BUCKETS = SUB_BUCKETS * 31;
+	uint32_t buckets[BUCKETS];
+
+	static int bucketOf(uint32_t ticks) {
+		if (ticks < SUB_BUCKETS)
+			return ticks;
+		int msb = 31 - __builtin_clz(ticks);
+		return SUB_BUCKETS * (msb - 1) + ((ticks >> (msb - 2)) & (SUB_BUCKETS - 1));
+	}
+
+	static uint32_t bucketTop(int bucket) {
+		if (bucket < SUB_BUCKETS)
+			return bucket;
+		int msb = bucket / SUB_BUCKETS + 1;
+		uint32_t width = 1u << (msb - 2);
+		return (SUB_BUCKETS + bucket % SUB_BUCKETS) * width + width - 1;
+	}
+
+  public:
+	uint32_t count;
+	uint32_t minTicks;
+	uint32_t maxTicks;
+	uint64_t totalTicks;
+
+	PerfHistogram() { reset(); }
+
+	void reset() {
+		memset(buckets, 0, sizeof(buckets));
+		count = 0;
+		minTicks = UINT32_MAX;
+		maxTicks = 0;
+		totalTicks = 0;
+	}
+
+	void add(uint32_t ticks) {
+		++buckets[bucketOf(ticks)];
+		++count;
+		totalTicks += ticks;
+		if (ticks < minTicks)
+			minTicks = ticks;
+		if (ticks > maxTicks)
+			maxTicks = ticks;
+	}
+
+	// Folds another histogram's samples into this one
+	void merge(const PerfHistogram &other) {
+		for (int i = 0; i < BUCKETS; ++i) {
+			buckets[i] += other.buckets[i];
+		}
+		count += other.count;
+		totalTicks += other.totalTicks;
+		if (other.minTicks < minTicks)
+			minTicks = other.minTicks;
+		if (other.maxTicks > maxTicks)
+			maxTicks = other.maxTicks;
+	}
+
+	uint32_t mean() const { return count ? totalTicks / count : 0; }
+
+	// Upper edge of the bucket holding the pct-th percentile, clamped to the observed max
+	uint32_t percentile(int pct) const {
+		if (count == 0)
+			return 0;
+		uint32_t rank = ((uint64_t)count * pct + 99) / 100;
+		uint32_t seen = 0;
+		for (int i = 0; i < BUCKETS; ++i) {
+			seen += buckets[i];
+			if (seen >= rank)
+				return bucketTop(i) < maxTicks ? bucketTop(i) : maxTicks;
+		}
+		return maxTicks;
+	}
+
+	// Prints [min,mean,max,p99]
+	void printJson() const {
+		Serial.print("[");
+		Serial.print(count ? minTicks : 0);
+		Serial.print(",");
+		Serial.print(mean());
+		Serial.print(",");
+		Serial.print(maxTicks);
+		Serial.print(",");
+		Serial.print(percentile(99));
+		Serial.print("]");
+	}
+};
+
+// One window of per-block timings: a histogram per stage and one for the whole block
+struct PerfWindow {
+	PerfHistogram stages[PERF_STAGE_COUNT];
+	PerfHistogram block;
+
+	void reset() {
+		for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+			stages[i].reset();
+		}
+		block.reset();
+	}
+
+	void merge(const PerfWindow &other) {
+		for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+			stages[i].merge(other.stages[i]);
+		}
+		block.merge(other.block);
+	}
+};
+
+// Per-block stage timings, double buffered so the audio side and the control side never touch the same window.
+// The audio side adds to the live window. The control side reads the retired one and then asks for a swap, which
+// the audio side performs at its next block: it clears the retired window and makes it live, and the window it was
+// filling becomes the retired one. Under DUAL_CORE the two sides run on different cores, so the handover goes
+// through atomics rather than a flag the compiler may cache.
+class PerfCounters {
+  private:
+	PerfWindow windows[2];
+	std::atomic<uint8_t> live{0};			  // written by the audio side
+	std::atomic<bool> swapRequested{false}; // set by the control side, cleared by the audio side
+	std::atomic<uint32_t> swaps{0};
+	uint32_t blockStartTicks = 0;
+	uint32_t lapStart = 0;
+
+  public:
+	// Clears both windows. Only while the audio side is not running, e.g. around a bench on the same thread
+	void reset() {
+		windows[0].reset();
+		windows[1].reset();
+		swapRequested.store(false, std::memory_order_relaxed);
+	}
+
+	// Audio side: the window being filled
+	const PerfWindow &liveWindow() const { return windows[live.load(std::memory_order_relaxed)]; }
+
+	// Control side: the window the last swap closed. Stays put until the next requestSwap()
+	const PerfWindow &retiredWindow() const { return windows[live.load(std::memory_order_acquire) ^ 1]; }
+
+	// Control side: how many windows have closed so far
+	uint32_t windowCount() const { return swaps.load(std::memory_order_acquire); }
+
+	// Control side: asks the audio side to close the live window at its next block. Returns false while an earlier
+	// request is still pending, when the retired window is not the control side's to read
+	bool requestSwap() {
+		if (swapRequested.load(std::memory_order_acquire))
+			return false;
+		swapRequested.store(true, std::memory_order_release);
+		return true;
+	}
+
+	void blockStart() {
+		if (swapRequested.load(std::memory_order_acquire)) {
+			uint8_t next = live.load(std::memory_order_relaxed) ^ 1;
+			windows[next].reset();
+			live.store(next, std::memory_order_release);
+			swaps.fetch_add(1, std::memory_order_release);
+			swapRequested.store(false, std::memory_order_release);
+		}
+		blockStartTicks = perfTicks();
+		lapStart = blockStartTicks;
+	}
+
+	// Charges the ticks since the previous lap (or blockStart) to stage
+	void lap(PerfStage stage) {
+		uint32_t now = perfTicks();
+		windows[live.load(std::memory_order_relaxed)].stages[stage].add(now - lapStart);
+		lapStart = now;
+	}
+
+	void blockEnd() { windows[live.load(std::memory_order_relaxed)].block.add(lapStart - blockStartTicks); }
+
+	// Prints the "perf" object for the VISUAL block: tick rate, the tick budget of one block of blockSize samples,
+	// then [min,mean,max,p99] ticks per block for each stage that ran and for the whole block, from the window the
+	// previous call closed. Closes the live window for the next call. If the audio side has not taken the previous
+	// request yet, e.g. because audio is stalled, prints only the tick rate and budget.
+	void printJson(size_t blockSize) {
+		Serial.print("\"perf\":{\"tpu\":");
+		Serial.print(perfTicksPerMicro());
+		Serial.print(",\"bud\":");
+		Serial.print((uint32_t)((uint64_t)perfTicksPerMicro() * 1000000 * blockSize / AUDIO_RATE));
+		if (!swapRequested.load(std::memory_order_acquire)) {
+			const PerfWindow &window = retiredWindow();
+			for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+				if (window.stages[i].count == 0)
+					continue;
+				Serial.print(",\"");
+				Serial.print(perfStageName(i));
+				Serial.print("\":");
+				window.stages[i].printJson();
+			}
+			Serial.print(",\"blk\":");
+			window.block.printJson();
+			requestSwap();
+		}
+		Serial.print("}");
+	}
+};
+
+inline PerfCounters perf; // one instance however many translation units include this
+
+inline void perfBlockStart() { perf.blockStart(); }
+inline void perfLap(PerfStage stage) { perf.lap(stage); }
+inline void perfBlockEnd() { perf.blockEnd(); }
+
+#else
+
+inline void perfBlockStart() {}
+inline void perfLap(PerfStage) {}
+inline void perfBlockEnd() {}
+
+#endif
+
+#endif
@@ -1,4 +1,5 @@
-#include "tables/sin8192_int16.h"
+#include "sine_tables.h"
+#include "voice_pool.h"
 #include <Meap.h> // MEAP library, includes all dependent libraries, including all Mozzi modules
 
 enum ChordQuality {    
@@ -102,22 +103,28 @@ class Chord {
 
 class ChordVoice {
   public:
-	mOscil<sin8192_int16_NUM_CELLS, AUDIO_RATE, int16_t> root;
-	mOscil<sin8192_int16_NUM_CELLS, AUDIO_RATE, int16_t> third;
-	mOscil<sin8192_int16_NUM_CELLS, AUDIO_RATE, int16_t> fifth;
-	mOscil<sin8192_int16_NUM_CELLS, AUDIO_RATE, int16_t> seventh;
+	// Four held chord tones plus room for the previous chord's release tails, read from the small RAM sine
+	VoicePool<8, SINE_SMALL_CELLS, AUDIO_RATE, int16_t, true> voices;
 
-	ChordVoice()
-		: root(sin8192_int16_DATA), third(sin8192_int16_DATA), fifth(sin8192_int16_DATA), seventh(sin8192_int16_DATA) {}
+	// Magnitude bound of render() output for the mix bus: every pool voice at full level
+	static constexpr int OUTPUT_BITS = decltype(voices)::OUTPUT_BITS;
 
+	ChordVoice() : voices(sineTable<SINE_SMALL_CELLS>(), 20, 400) {}
+
+	// Releases the current chord and starts c; tones shared with the previous chord keep sounding
 	void setChord(const Chord &c) {
-		root.setFreq(mtof(c.getMidiNote(0)));
-		third.setFreq(mtof(c.getMidiNote(1)));
-		fifth.setFreq(mtof(c.getMidiNote(2)));
-		seventh.setFreq(mtof(c.getMidiNote(3)));
+		releaseAll();
+		for (int i = 0; i < 4; ++i) {
+			noteOn(c.getMidiNote(i));
+		}
 	}
 
-	int64_t next() { return root.next() + third.next() + fifth.next() + seventh.next(); }
+	void noteOn(int midiNote) { voices.noteOn(midiNote); }
+
+	void releaseAll() { voices.releaseAll(); }
+
+	// Renders n samples into buf, overwriting it
+	void render(int32_t *buf, size_t n) { voices.render(buf, n); }
 };
 
 class State {
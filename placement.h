@@ -0,0 +1,62 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+// Host builds, e.g. tools/resampler_bench.cpp
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+// Memory placement for the audio path. On ESP32 code and const tables default to flash, read through a small cache
+// shared with everything else, so a miss in the middle of a block stalls the render; the drum loop streaming out of
+// flash keeps evicting both. AUDIO_HOT puts a function in IRAM and placeTable() copies a table into RAM at setup().
+// Member arrays of global objects (the chorus and reverb delay lines, the voice banks) are already in DRAM.
+// tools/map_report.py checks where everything ended up. Off-target both are no-ops.
+#if defined(ESP32)
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#define AUDIO_HOT IRAM_ATTR
+#else
+#define AUDIO_HOT
+#endif
+
+enum TablePlacement {
+	PLACE_INTERNAL, // internal DRAM: small tables read every sample
+	PLACE_PSRAM		// external RAM: tables too large for internal RAM, e.g. samples, kept off the flash cache
+};
+
+// Returns a copy of cells cells of table in the requested RAM, or table itself when that heap can't hold it (or
+// off-target). Call once from setup(); the copy is never freed
+template <class T>
+const T *placeTable(const T *table, size_t cells, TablePlacement where = PLACE_INTERNAL) {
+#if defined(ESP32)
+	uint32_t caps = where == PLACE_PSRAM ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	T *copy = (T *)heap_caps_malloc(cells * sizeof(T), caps);
+	if (copy == nullptr)
+		return table;
+	memcpy(copy, table, cells * sizeof(T));
+	return copy;
+#else
+	(void)cells;
+	(void)where;
+	return table;
+#endif
+}
+
+// Returns bytes of zeroed memory in the requested RAM, or nullptr when that heap can't hold them (any heap off-target).
+// Call from setup(); for buffers such as long delay lines that don't fit in internal RAM
+inline void *placeBuffer(size_t bytes, TablePlacement where = PLACE_INTERNAL) {
+#if defined(ESP32)
+	uint32_t caps = where == PLACE_PSRAM ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	return heap_caps_calloc(1, bytes, caps);
+#else
+	(void)where;
+	return calloc(1, bytes);
+#endif
+}
+
+#endif
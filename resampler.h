@@ -0,0 +1,143 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "placement.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+namespace ResamplerDetail {
+template <class S, class = void> struct HasStart : std::false_type {};
+template <class S> struct HasStart<S, std::void_t<decltype(std::declval<S &>().start())>> : std::true_type {};
+} // namespace ResamplerDetail
+
+// Polyphase sample-rate converter for a sample source stored at a rate other than the output's. Each output sample
+// is a TAPS-tap Kaiser-windowed sinc over the source samples around its position, with the taps for PHASES fractional
+// positions worked out once at construction and linearly interpolated in between. The cutoff sits below the lower of
+// the two Nyquist frequencies, so downsampling doesn't alias and upsampling doesn't leave images, where stepping
+// through the table with a phase increment (mSample) does both. Equal rates pass the source straight through. Source
+// needs next() and OUTPUT_BITS; start() is forwarded when it has one. tools/resampler_bench.cpp measures cost and
+// aliasing on the host.
+template <class Source, unsigned int TAPS = 16, unsigned int PHASES = 64>
+class Resampler {
+	static_assert(TAPS % 2 == 0, "taps must be even");
+	static_assert((PHASES & (PHASES - 1)) == 0 && PHASES <= 1024, "phases must be a power of two up to 1024");
+
+  private:
+	static constexpr int COEFF_BITS = 14; // each phase's taps sum to 1 in Q14
+	static constexpr int FRAC_BITS = 16;
+	static constexpr int PHASE_SHIFT = FRAC_BITS - __builtin_ctz(PHASES);
+	static constexpr float CUTOFF = 0.8f; // of the lower Nyquist frequency, leaving the taps room to roll off before it
+	static constexpr float KAISER_BETA = 7.0f;
+
+	Source &source;
+	int16_t coeffs[(PHASES + 1) * TAPS]; // one row per phase, the last one position 1 for interpolating into
+	int32_t history[2 * TAPS];			 // last TAPS source samples, written twice so any TAPS in a row are contiguous
+	unsigned int head = 0;
+	uint32_t frac = 0; // position past the middle of the history, Q16
+	uint32_t increment;
+	bool bypass;
+
+	static float besselI0(float x) {
+		float sum = 1, term = 1;
+		for (int k = 1; k < 20; ++k) {
+			term *= (x / (2 * k)) * (x / (2 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	void design(float cutoff) {
+		const float half = TAPS / 2;
+		for (unsigned int p = 0; p <= PHASES; ++p) {
+			float row[TAPS];
+			float sum = 0;
+			for (unsigned int i = 0; i < TAPS; ++i) {
+				// Distance from the output position to source sample i, where i = TAPS / 2 - 1 is the one at or before it
+				float t = (float)p / PHASES + half - 1 - i;
+				float x = 2 * cutoff * t;
+				float sinc = t == 0 ? 1 : sin((float)M_PI * x) / ((float)M_PI * x);
+				float r = t / half;
+				float window = r * r < 1 ? besselI0(KAISER_BETA * sqrt(1 - r * r)) / besselI0(KAISER_BETA) : 0;
+				row[i] = sinc * window;
+				sum += row[i];
+			}
+			for (unsigned int i = 0; i < TAPS; ++i) {
+				coeffs[p * TAPS + i] = (int16_t)lroundf(row[i] / sum * (1 << COEFF_BITS));
+			}
+		}
+	}
+
+	void push(int32_t x) {
+		history[head] = history[head + TAPS] = x;
+		head = (head + 1) % TAPS;
+	}
+
+  public:
+	// Magnitude bound of render() output for the mix bus: the filter can overshoot the source's range
+	static constexpr int OUTPUT_BITS = Source::OUTPUT_BITS + 1;
+
+	Resampler(Source &src, uint32_t sourceRate, uint32_t outputRate) : source(src) {
+		setRates(sourceRate, outputRate);
+	}
+
+	// Redesigns the filter for new rates, e.g. once a streamed file's rate is known. Not while rendering
+	void setRates(uint32_t sourceRate, uint32_t outputRate) {
+		increment = (uint32_t)(((uint64_t)sourceRate << FRAC_BITS) / outputRate);
+		bypass = sourceRate == outputRate;
+		float nyquist = 0.5f * (sourceRate < outputRate ? 1.0f : (float)outputRate / sourceRate);
+		design(CUTOFF * nyquist);
+		reset();
+	}
+
+	// Starts the source from the top, if it can, with silence before it
+	void start() {
+		if constexpr (ResamplerDetail::HasStart<Source>::value)
+			source.start();
+		reset();
+	}
+
+	// Clears the history and fills the look-ahead half from the source, up to the first sample's right-hand taps
+	void reset() {
+		memset(history, 0, sizeof(history));
+		head = 0;
+		frac = 0;
+		if (bypass)
+			return;
+		for (unsigned int i = 0; i <= TAPS / 2; ++i) {
+			push(source.next());
+		}
+	}
+
+	int32_t AUDIO_HOT next() {
+		if (bypass)
+			return source.next();
+		const int16_t *c0 = coeffs + (frac >> PHASE_SHIFT) * TAPS;
+		const int16_t *c1 = c0 + TAPS;
+		int32_t w = (frac & ((1 << PHASE_SHIFT) - 1)) << (15 - PHASE_SHIFT); // Q15 between the two phases
+		const int32_t *x = history + head;
+		int32_t acc = 1 << (COEFF_BITS - 1);
+		for (unsigned int i = 0; i < TAPS; ++i) {
+			int32_t c = c0[i] + (((c1[i] - c0[i]) * w) >> 15);
+			acc += c * x[i];
+		}
+		frac += increment;
+		while (frac >= (1u << FRAC_BITS)) {
+			frac -= 1u << FRAC_BITS;
+			push(source.next());
+		}
+		return acc >> COEFF_BITS;
+	}
+
+	// Renders n samples into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		for (size_t i = 0; i < n; ++i) {
+			buf[i] = next();
+		}
+	}
+};
+
+#endif
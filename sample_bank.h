@@ -0,0 +1,277 @@
+#ifndef SAMPLE_BANK_H
+#define SAMPLE_BANK_H
+
+#include "placement.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Sample files: LittleFS on the board (upload the sketch's data/ folder with the filesystem uploader), plain files
+// under SAMPLE_BANK_ROOT on the host, with the same paths on both
+#if defined(ESP32)
+#include <FS.h>
+#include <LittleFS.h>
+
+class SampleFile {
+  private:
+	File file;
+
+  public:
+	static bool begin() { return LittleFS.begin(); }
+	bool open(const char *path) {
+		file = LittleFS.open(path, "r");
+		return (bool)file;
+	}
+	size_t read(void *buf, size_t bytes) { return file.read((uint8_t *)buf, bytes); }
+	bool seek(uint32_t pos) { return file.seek(pos); }
+	void close() { file.close(); }
+};
+#else
+#include <stdio.h>
+
+#ifndef SAMPLE_BANK_ROOT
+#define SAMPLE_BANK_ROOT "data"
+#endif
+
+class SampleFile {
+  private:
+	FILE *file = nullptr;
+
+  public:
+	static bool begin() { return true; }
+	bool open(const char *path) {
+		char full[256];
+		snprintf(full, sizeof(full), "%s%s", SAMPLE_BANK_ROOT, path);
+		file = fopen(full, "rb");
+		return file != nullptr;
+	}
+	size_t read(void *buf, size_t bytes) { return fread(buf, 1, bytes, file); }
+	bool seek(uint32_t pos) { return fseek(file, pos, SEEK_SET) == 0; }
+	void close() {
+		if (file)
+			fclose(file);
+		file = nullptr;
+	}
+};
+#endif
+
+// A bank of 16-bit mono .wav files streamed from storage, so announcements and loops can change without reflashing.
+// Files load lazily: add() only records the path, and the header and the first HEAD_SAMPLES samples are read into RAM
+// the first time a file is played (or by load(), to have it ready). Playback starts from that head at once while
+// fill(), called outside the audio path (from the control tick), streams the rest through two CHUNK_SAMPLES halves
+// of a ring: the audio side plays one half while fill() reads the next chunk into the other. One file plays at a
+// time. If the stream falls behind, playback holds and outputs silence, counted in underruns().
+template <unsigned int MAX_FILES, unsigned int HEAD_SAMPLES = 4096, unsigned int CHUNK_SAMPLES = 1024>
+class SampleBank {
+  private:
+	struct Entry {
+		const char *path = nullptr;
+		uint32_t rate = 0;
+		uint32_t length = 0;	 // samples
+		uint32_t dataOffset = 0; // bytes into the file
+		int16_t *head = nullptr;
+		uint32_t headLength = 0;
+		std::atomic<uint8_t> state{UNLOADED};
+	};
+	enum EntryState : uint8_t { UNLOADED, LOADED, MISSING };
+
+	Entry entries[MAX_FILES];
+	unsigned int count = 0;
+
+	// Stream, owned by fill()
+	SampleFile file;
+	int openEntry = -1;
+	uint32_t fillSeq = 0;
+	uint32_t nextChunk = 0;
+
+	// Shared: requests from the audio side, chunks from fill(). A half is valid for the request and chunk in its tag
+	int16_t ring[2][CHUNK_SAMPLES];
+	std::atomic<uint32_t> tags[2];
+	std::atomic<uint32_t> requestSeq{0};
+	std::atomic<int> requestEntry{-1};
+	std::atomic<int32_t> readingChunk{-1}; // chunk the audio side is playing, -1 in the head
+	std::atomic<uint32_t> underrunCount{0};
+
+	// Playback, owned by the audio side
+	int entry = -1;
+	uint32_t seq = 0;
+	uint32_t pos = 0;
+	bool playing = false;
+
+	static uint32_t tagOf(uint32_t s, uint32_t chunk) { return s << 16 | (chunk & 0xffff); }
+
+	static uint32_t readLe(const uint8_t *p, int bytes) {
+		uint32_t v = 0;
+		for (int i = bytes - 1; i >= 0; --i) {
+			v = v << 8 | p[i];
+		}
+		return v;
+	}
+
+	// Reads the .wav header and head of e; false if the file is missing or not 16-bit mono PCM
+	bool readHeader(Entry &e) {
+		SampleFile f;
+		if (!f.open(e.path))
+			return false;
+		uint8_t riff[12];
+		bool ok = f.read(riff, 12) == 12 && memcmp(riff, "RIFF", 4) == 0 && memcmp(riff + 8, "WAVE", 4) == 0;
+		uint32_t at = 12;
+		bool format = false;
+		while (ok) {
+			uint8_t chunk[8];
+			if (f.read(chunk, 8) != 8) {
+				ok = false;
+				break;
+			}
+			uint32_t size = readLe(chunk + 4, 4);
+			at += 8;
+			if (memcmp(chunk, "fmt ", 4) == 0) {
+				uint8_t fmt[16];
+				ok = size >= 16 && f.read(fmt, 16) == 16 && readLe(fmt, 2) == 1 && readLe(fmt + 2, 2) == 1 &&
+					 readLe(fmt + 14, 2) == 16;
+				e.rate = readLe(fmt + 4, 4);
+				format = true;
+			} else if (memcmp(chunk, "data", 4) == 0) {
+				e.dataOffset = at;
+				e.length = size / 2;
+				break;
+			}
+			at += size + (size & 1);
+			ok = ok && f.seek(at);
+		}
+		ok = ok && format;
+		if (ok) {
+			e.headLength = e.length < HEAD_SAMPLES ? e.length : HEAD_SAMPLES;
+			e.head = (int16_t *)malloc(e.headLength * sizeof(int16_t));
+			ok = e.head != nullptr && f.seek(e.dataOffset) &&
+				 f.read(e.head, e.headLength * sizeof(int16_t)) == e.headLength * sizeof(int16_t);
+		}
+		f.close();
+		if (!ok) {
+			free(e.head);
+			e.head = nullptr;
+		}
+		return ok;
+	}
+
+  public:
+	// Magnitude bound of render() output for the mix bus: 16-bit samples
+	static constexpr int OUTPUT_BITS = 15;
+
+	SampleBank() {
+		tags[0] = tags[1] = UINT32_MAX;
+	}
+
+	// Mounts the storage; call once from setup()
+	static bool begin() { return SampleFile::begin(); }
+
+	// Registers a file (path kept, not copied) and returns its index, or -1 when the bank is full
+	int add(const char *path) {
+		if (count == MAX_FILES)
+			return -1;
+		entries[count].path = path;
+		return count++;
+	}
+
+	// Reads a file's header and head now rather than on first play. Control side; false if it can't be played
+	bool load(int index) {
+		Entry &e = entries[index];
+		if (e.state.load(std::memory_order_acquire) == UNLOADED)
+			e.state.store(readHeader(e) ? LOADED : MISSING, std::memory_order_release);
+		return e.state.load(std::memory_order_relaxed) == LOADED;
+	}
+
+	// Sample rate of a loaded file
+	uint32_t rate(int index) { return entries[index].rate; }
+
+	// Streams the next chunk of the playing file if a ring half is free, loading the file first if needed. Call
+	// regularly from outside the audio path; reads at most one chunk
+	void fill() {
+		uint32_t s = requestSeq.load(std::memory_order_acquire);
+		int index = requestEntry.load(std::memory_order_relaxed);
+		if (index < 0)
+			return;
+		if (!load(index))
+			return;
+		if (s != fillSeq) {
+			fillSeq = s;
+			nextChunk = 0;
+			if (openEntry != index) {
+				file.close();
+				openEntry = file.open(entries[index].path) ? index : -1;
+			}
+		}
+		Entry &e = entries[index];
+		uint32_t streamed = e.headLength + nextChunk * CHUNK_SAMPLES;
+		// The half for nextChunk last held nextChunk - 2, which the audio side has to be past
+		if (openEntry != index || streamed >= e.length || (int32_t)nextChunk > readingChunk.load() + 1)
+			return;
+		uint32_t samples = e.length - streamed < CHUNK_SAMPLES ? e.length - streamed : CHUNK_SAMPLES;
+		int half = nextChunk & 1;
+		tags[half].store(UINT32_MAX, std::memory_order_relaxed);
+		if (!file.seek(e.dataOffset + streamed * sizeof(int16_t)) ||
+			file.read(ring[half], samples * sizeof(int16_t)) != samples * sizeof(int16_t))
+			return;
+		tags[half].store(tagOf(s, nextChunk), std::memory_order_release);
+		++nextChunk;
+	}
+
+	// Starts file index from the top. Audio side
+	void play(int index) {
+		entry = index;
+		start();
+	}
+
+	// Restarts the last file played
+	void start() {
+		if (entry < 0)
+			return;
+		pos = 0;
+		playing = true;
+		readingChunk.store(-1);
+		requestEntry.store(entry, std::memory_order_relaxed);
+		seq = (seq + 1) & 0xffff;
+		requestSeq.store(seq, std::memory_order_release);
+	}
+
+	bool isPlaying() { return playing; }
+
+	uint32_t underruns() { return underrunCount.load(std::memory_order_relaxed); }
+
+	int32_t AUDIO_HOT next() {
+		if (!playing)
+			return 0;
+		Entry &e = entries[entry];
+		uint8_t state = e.state.load(std::memory_order_acquire);
+		if (state != LOADED) {
+			playing = state == UNLOADED; // wait for fill() to load it, or give up on a missing file
+			return 0;
+		}
+		if (pos >= e.length) {
+			playing = false;
+			return 0;
+		}
+		if (pos < e.headLength)
+			return e.head[pos++];
+		uint32_t offset = pos - e.headLength;
+		uint32_t chunk = offset / CHUNK_SAMPLES;
+		if ((int32_t)chunk != readingChunk.load(std::memory_order_relaxed))
+			readingChunk.store(chunk, std::memory_order_release);
+		if (tags[chunk & 1].load(std::memory_order_acquire) != tagOf(seq, chunk)) {
+			underrunCount.fetch_add(1, std::memory_order_relaxed);
+			return 0;
+		}
+		++pos;
+		return ring[chunk & 1][offset % CHUNK_SAMPLES];
+	}
+
+	// Renders n samples into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		for (size_t i = 0; i < n; ++i) {
+			buf[i] = next();
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef SLICED_DRUMS_H
+#define SLICED_DRUMS_H
+
+#include "adpcm_sample.h"
+#include "placement.h"
+
+// Pattern and hits written by tools/slice_drums.py
+struct DrumSliceMap {
+	const uint32_t *sliceStart;	 // first sample of each distinct hit, on an ADPCM block boundary
+	const uint32_t *sliceLength; // samples in each hit
+	const uint32_t *hitTime;	 // when each hit plays, in 1/65536 steps from the loop start, ascending
+	const uint8_t *hitSlice;	 // which slice each hit plays
+	uint8_t hitCount;
+	uint8_t loopSteps;
+};
+
+// Drum loop played as its hits on a step grid: each hit starts at its place in the pattern, scaled to the current
+// step length and swing, so the loop follows the sequencer's tempo without being repitched. The clock runs on the
+// audio side and places hits to the sample; syncBeat() pulls it onto the control side's beats. A new hit cuts the
+// previous one with a short fade, and every slice fades out over its last samples, where the next hit's pre-roll
+// used to start. The hits are ADPCM blocks of NUM_SAMPLES samples in all, stored at UPDATE_RATE.
+template <unsigned int NUM_SAMPLES, unsigned int BLOCK_SAMPLES, unsigned int UPDATE_RATE>
+class SlicedDrums {
+  private:
+	static constexpr int GAIN_BITS = 15;
+	static constexpr int32_t UNITY_GAIN = 1 << GAIN_BITS;
+	static constexpr uint32_t FADE_SAMPLES = 64;
+	static constexpr int32_t FADE_STEP = UNITY_GAIN / FADE_SAMPLES;
+
+	AdpcmSample<NUM_SAMPLES, BLOCK_SAMPLES, UPDATE_RATE> voices[2];
+	int32_t gain[2] = {UNITY_GAIN, UNITY_GAIN}; // Q15
+	bool fading[2] = {false, false};
+	int active = 0;
+
+	const DrumSliceMap &map;
+	uint32_t longStep;	// samples in the even (on-beat) and odd steps, swing moving time from odd to even
+	uint32_t shortStep;
+	uint8_t stepsPerBeat = 4;
+	uint8_t step = 0;
+	uint8_t nextHit = 0;
+	uint32_t stepLength; // samples in the current step, including any sync correction
+	uint32_t stepPos = 0;
+
+	uint32_t lengthOf(uint8_t s) { return (s & 1) ? shortStep : longStep; }
+
+	uint32_t hitOffset(uint8_t hit) {
+		return (uint32_t)(((uint64_t)(map.hitTime[hit] & 0xffff) * stepLength + 0x8000) >> 16);
+	}
+
+	bool hitInStep(uint8_t hit) { return hit < map.hitCount && (map.hitTime[hit] >> 16) == step; }
+
+	void beginStep(uint8_t s) {
+		step = s;
+		stepPos = 0;
+		stepLength = lengthOf(s);
+		nextHit = 0;
+		while (nextHit < map.hitCount && (map.hitTime[nextHit] >> 16) < s) {
+			++nextHit;
+		}
+	}
+
+	void trigger(uint8_t slice) {
+		fading[active] = true;
+		active ^= 1;
+		gain[active] = UNITY_GAIN;
+		fading[active] = false;
+		voices[active].playRange(map.sliceStart[slice], map.sliceLength[slice]);
+	}
+
+	void AUDIO_HOT renderVoices(int32_t *buf, size_t n) {
+		memset(buf, 0, n * sizeof(int32_t));
+		for (int v = 0; v < 2; ++v) {
+			AdpcmSample<NUM_SAMPLES, BLOCK_SAMPLES, UPDATE_RATE> &voice = voices[v];
+			for (size_t i = 0; i < n && voice.isPlaying(); ++i) {
+				int32_t g = gain[v];
+				uint32_t left = voice.remaining();
+				if (left < FADE_SAMPLES && (int32_t)left * FADE_STEP < g)
+					g = left * FADE_STEP;
+				buf[i] += (voice.next() * g) >> GAIN_BITS;
+				if (fading[v]) {
+					gain[v] -= FADE_STEP;
+					if (gain[v] <= 0)
+						voice.stop();
+				}
+			}
+		}
+	}
+
+  public:
+	// Magnitude bound of render() output for the mix bus: two 16-bit hits overlap while one fades
+	static constexpr int OUTPUT_BITS = 16;
+
+	SlicedDrums(const uint8_t *adpcm_data, const DrumSliceMap &slice_map)
+		: voices{adpcm_data, adpcm_data}, map(slice_map) {
+		voices[0].stop();
+		voices[1].stop();
+		setTempo(UPDATE_RATE / 2, 4, 0);
+		beginStep(0);
+	}
+
+	// Swaps in a copy of the same data, e.g. one placed in RAM
+	void setData(const uint8_t *adpcm_data) {
+		voices[0].setData(adpcm_data);
+		voices[1].setData(adpcm_data);
+	}
+
+	// Beat length in samples, pattern steps per beat (4 plays the loop's sixteenths as written, 2 half time, 8 double
+	// time) and swing, 0-1 of a step moved from the odd steps to the even ones. The current step takes the new length
+	// at once.
+	void setTempo(uint32_t beatSamples, uint8_t steps_per_beat, float swing) {
+		stepsPerBeat = steps_per_beat;
+		uint32_t base = beatSamples / steps_per_beat;
+		longStep = (uint32_t)(base * (1 + swing));
+		shortStep = 2 * base - longStep;
+		if (shortStep == 0)
+			shortStep = 1;
+		stepLength = lengthOf(step);
+		if (stepLength < stepPos)
+			stepLength = stepPos;
+	}
+
+	// Marks a beat on the control side's clock. Running slightly ahead, the clock waits for it by stretching the
+	// current step; behind, it skips to the next beat. Either way the pattern keeps its place in the loop.
+	void syncBeat() {
+		uint8_t inBeat = step % stepsPerBeat;
+		uint32_t beatPos = (inBeat / 2) * (longStep + shortStep) + ((inBeat & 1) ? longStep : 0) + stepPos;
+		uint32_t beatLength = (stepsPerBeat / 2) * (longStep + shortStep);
+		if (beatPos * 2 < beatLength) {
+			stepLength += beatPos;
+		} else {
+			beginStep((step - inBeat + stepsPerBeat) % map.loopSteps);
+		}
+	}
+
+	// Renders n samples into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		while (n > 0) {
+			if (stepPos >= stepLength) {
+				beginStep((step + 1) % map.loopSteps);
+			}
+			while (hitInStep(nextHit) && hitOffset(nextHit) <= stepPos) {
+				trigger(map.hitSlice[nextHit++]);
+			}
+			uint32_t until = hitInStep(nextHit) ? hitOffset(nextHit) : stepLength;
+			size_t run = until - stepPos < n ? until - stepPos : n;
+			renderVoices(buf, run);
+			buf += run;
+			n -= run;
+			stepPos += run;
+		}
+	}
+};
+
+#endif
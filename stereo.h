@@ -0,0 +1,43 @@
+#ifndef STEREO_H
+#define STEREO_H
+
+#include <stdint.h>
+
+// One stereo sample. Blocks of frames keep left and right interleaved, so code that handles both lanes in the same loop
+// iteration shares the loads, gains and loop overhead between them, and compilers can pack the pair into two-lane SIMD
+// where the target has it.
+struct StereoFrame {
+	int32_t l, r;
+
+	static StereoFrame mono(int32_t x) { return {x, x}; }
+
+	// Mono sum, (l + r) / 2
+	int32_t mid() const { return (l + r) >> 1; }
+
+	StereoFrame operator+(StereoFrame o) const { return {l + o.l, r + o.r}; }
+};
+
+inline int32_t magnitude(int32_t x) { return x < 0 ? -x : x; }
+
+inline int32_t magnitude(StereoFrame f) {
+	int32_t l = magnitude(f.l), r = magnitude(f.r);
+	return l > r ? l : r;
+}
+
+// Left and right gains for a pan position from 0 (left) through 128 (centre) to 256 (right). It is a balance law
+// rather than constant power: a centred source keeps its mono level in both channels, and no channel ever gets more
+// than unity, so each channel of the bus keeps the mono headroom proof
+struct Pan {
+	static constexpr int BITS = 8;
+	static constexpr int32_t CENTRE = 1 << (BITS - 1);
+
+	int32_t left, right; // 0 to 2^BITS
+
+	constexpr explicit Pan(int32_t pan = CENTRE)
+		: left(pan <= CENTRE ? 1 << BITS : 2 * ((1 << BITS) - pan)), right(pan >= CENTRE ? 1 << BITS : 2 * pan) {}
+
+	// x panned; x * 2^BITS has to fit int32
+	StereoFrame place(int32_t x) const { return {(x * left) >> BITS, (x * right) >> BITS}; }
+};
+
+#endif
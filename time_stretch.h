@@ -0,0 +1,132 @@
+#ifndef TIME_STRETCH_H
+#define TIME_STRETCH_H
+
+#include "placement.h"
+
+#include <Arduino.h>
+
+// WSOLA time stretch of a looping source: plays it at 0-2x speed without changing pitch. The output crossfades from
+// one grain of the source to the next every HOP samples, the grains starting HOP * speed apart in the source, each
+// nudged by up to SEARCH samples to where it lines up best with the grain it replaces. The source is pulled in order
+// at its own rate into a small ring, so nothing seeks, and the search for the next grain is spread over the current
+// one: every render() does the same bounded work per sample (at most 2 source reads, CANDIDATES / HOP correlations of
+// CORRELATION / 2 taps, and one crossfade), whatever the speed. Source needs next() and OUTPUT_BITS, e.g. a looping
+// AdpcmSample at speed 1.
+template <class Source, unsigned int HOP = 256>
+class TimeStretch {
+	static_assert((HOP & (HOP - 1)) == 0, "hop must be a power of two");
+
+  private:
+	static constexpr int32_t SEARCH = HOP / 4;
+	static constexpr int32_t CANDIDATES = 2 * SEARCH + 1;
+	static constexpr int32_t CORRELATION = HOP / 2;
+	static constexpr uint32_t MAX_ADVANCE = 2 * HOP; // source samples per hop at 2x
+	// Samples pulled ahead of the nominal grain start: enough for the next grain's search at the fastest speed
+	static constexpr uint32_t LEAD = MAX_ADVANCE + SEARCH + CORRELATION;
+	static constexpr uint32_t RING = 8 * HOP;
+	static_assert(RING > 2 * MAX_ADVANCE + SEARCH + LEAD, "ring must span the fading grain to the lead");
+	static constexpr int FADE_BITS = 15;
+
+	Source &source;
+	int16_t ring[RING];
+	int16_t fade[HOP]; // raised cosine, 0 to 1 over a hop, Q15
+	uint32_t written = 0; // source samples pulled into the ring so far
+
+	uint32_t nominal = 0; // where the current grain would start without the search
+	uint32_t grain = 0;	  // where it does start
+	uint32_t previous = 0; // where the grain fading out continues from
+	uint32_t pos = 0;	  // output samples into the hop
+	uint32_t advance = HOP;
+	uint32_t nextAdvance = HOP;
+
+	int32_t candidate = 0; // next offset to try for the next grain, from 0 (-SEARCH)
+	float bestScore = 0;
+	int32_t bestOffset = 0;
+
+	int32_t at(uint32_t i) { return ring[i & (RING - 1)]; }
+
+	void pull(uint32_t upTo) {
+		while ((int32_t)(upTo - written) > 0) {
+			ring[written++ & (RING - 1)] = source.next();
+		}
+	}
+
+	// Similarity of the grain fading in at the end of this hop, if it started at offset, with the continuation of the
+	// current one: their correlation, signed and squared, over the candidate's energy, so loud candidates don't win
+	// just for being loud
+	float AUDIO_HOT score(int32_t offset) {
+		uint32_t target = grain + HOP;
+		uint32_t start = nominal + advance - SEARCH + offset;
+		int32_t cross = 0;
+		int32_t energy = 1;
+		for (int32_t i = 0; i < CORRELATION; i += 2) {
+			int32_t c = at(start + i) >> 4;
+			cross += (at(target + i) >> 4) * c;
+			energy += c * c;
+		}
+		return (float)cross * (float)abs(cross) / (float)energy;
+	}
+
+	void AUDIO_HOT search(int32_t count) {
+		for (; count > 0 && candidate < CANDIDATES; --count, ++candidate) {
+			float s = score(candidate);
+			if (candidate == 0 || s > bestScore) {
+				bestScore = s;
+				bestOffset = candidate;
+			}
+		}
+	}
+
+	void AUDIO_HOT nextGrain() {
+		search(CANDIDATES);
+		previous = grain + HOP;
+		nominal += advance;
+		grain = nominal - SEARCH + bestOffset;
+		advance = nextAdvance;
+		candidate = 0;
+		pos = 0;
+	}
+
+  public:
+	// Magnitude bound of render() output for the mix bus: crossfades of the source
+	static constexpr int OUTPUT_BITS = Source::OUTPUT_BITS;
+
+	TimeStretch(Source &src) : source(src) {
+		for (unsigned int i = 0; i < HOP; ++i) {
+			float s = sin(PI * 0.5f * i / HOP);
+			fade[i] = (int16_t)(s * s * ((1 << FADE_BITS) - 1));
+		}
+		memset(ring, 0, sizeof(ring));
+		nominal = SEARCH; // room for the first search below the start
+		grain = previous = nominal;
+		pull(nominal + LEAD);
+	}
+
+	// Tempo relative to the source, 0-2; takes effect at the next grain
+	void setSpeed(float speed) {
+		float a = speed * HOP;
+		nextAdvance = a < 0 ? 0 : (a > MAX_ADVANCE ? MAX_ADVANCE : (uint32_t)a);
+	}
+
+	// Renders n samples into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		if (pos == HOP) {
+			nextGrain();
+		}
+		// Share of the next grain's search that falls in these n samples, rounded up
+		search((CANDIDATES * n + HOP - 1) / HOP);
+		for (size_t i = 0; i < n; ++i) {
+			if (pos == HOP) {
+				nextGrain();
+			}
+			// Keep LEAD samples ahead of the nominal position, pulling this hop's advance evenly across it
+			pull(nominal + LEAD + advance * (pos + 1) / HOP);
+			int32_t out = at(previous + pos);
+			int32_t in = at(grain + pos);
+			buf[i] = out + (((in - out) * fade[pos]) >> FADE_BITS);
+			++pos;
+		}
+	}
+};
+
+#endif
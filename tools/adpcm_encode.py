@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""Encode a sample as IMA ADPCM blocks for AdpcmSample (adpcm_sample.h).
+
+The input is a 16-bit PCM .wav (downmixed to mono and resampled to --rate through a Kaiser-windowed sinc lowpass, see
+resample()) or an existing Mozzi-style table header (`<name>_DATA [] = {...}`, used as is). The output header holds
+4-bit codes in blocks of --block samples, each block led by the decoder state it starts from, so playback can start or
+loop at any block:
+
+    int16 predictor (little endian), uint8 step index, uint8 reserved, block/2 bytes of codes (low nibble first)
+
+    python3 tools/adpcm_encode.py assets/neo_soul_drums.wav -o neo_soul_drums_adpcm.h
+
+tools/embed_assets.py uses the same encoder for the "adpcm" format at build time.
+"""
+
+import argparse
+import math
+import operator
+import os
+import re
+import struct
+import sys
+import wave
+
+STEPS = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+    107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871,
+    5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767,
+]
+INDEX_ADJUST = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+RESAMPLE_TAPS = 64  # per output sample, at the lower of the two rates
+RESAMPLE_BETA = 7.3  # Kaiser window: about 75 dB of stopband over this many taps
+RESAMPLE_CUTOFF = 0.9  # of the lower Nyquist frequency, at half amplitude
+
+
+def bessel_i0(x):
+    total, term, k = 1.0, 1.0, 1
+    while term > 1e-12 * total:
+        term *= (x / (2 * k)) ** 2
+        total += term
+        k += 1
+    return total
+
+
+def resample(samples, source_rate, rate):
+    """Kaiser-windowed sinc resampling, as Resampler (resampler.h) does at run time but with every phase exact: the
+    lowpass sits just below the lower Nyquist frequency, so going down in rate nothing above it folds back"""
+    ratio = min(1.0, rate / source_rate)
+    cutoff = 0.5 * RESAMPLE_CUTOFF * ratio  # cycles per source sample
+    half = int(math.ceil(RESAMPLE_TAPS / 2 / ratio))  # source samples either side of the output position
+    norm = bessel_i0(RESAMPLE_BETA)
+    padded = [0.0] * half + list(samples) + [0.0] * (half + 1)
+    g = math.gcd(source_rate, rate)
+    step, outputs = source_rate // g, rate // g  # output i sits at source position i * step / outputs
+    rows = {}
+    out = []
+    for i in range(int(len(samples) * rate / source_rate)):
+        j, phase = divmod(i * step, outputs)
+        row = rows.get(phase)
+        if row is None:
+            row = []
+            for k in range(-half + 1, half + 1):
+                t = k - phase / outputs  # distance from the output position to source sample j + k
+                x = 2 * cutoff * t
+                sinc = 2 * cutoff * (math.sin(math.pi * x) / (math.pi * x) if x else 1.0)
+                r = t / half
+                row.append(sinc * bessel_i0(RESAMPLE_BETA * math.sqrt(1 - r * r)) / norm if r * r < 1 else 0.0)
+            total = sum(row)
+            row = [c / total for c in row]
+            rows[phase] = row
+        start = j + 1  # padded index of source sample j - half + 1
+        y = sum(map(operator.mul, row, padded[start:start + 2 * half]))
+        out.append(max(-32768, min(32767, int(round(y)))))
+    return out
+
+
+def read_wav(path, rate):
+    with wave.open(path) as w:
+        if w.getsampwidth() != 2:
+            sys.exit(f"{path}: only 16-bit PCM is supported")
+        channels, source_rate = w.getnchannels(), w.getframerate()
+        frames = w.readframes(w.getnframes())
+    values = struct.unpack(f"<{len(frames) // 2}h", frames)
+    mono = [sum(values[i:i + channels]) / channels for i in range(0, len(values), channels)]
+    if source_rate == rate:
+        return [int(round(x)) for x in mono]
+    return resample(mono, source_rate, rate)
+
+
+def read_header(path):
+    text = open(path).read()
+    m = re.search(r"(\w+)_DATA\s*\[\s*\]\s*=\s*\{(.*?)\}", text, re.S)
+    if not m:
+        sys.exit(f"{path}: no <name>_DATA [] = {{...}} table found")
+    rate = re.search(r"#define\s+\w+_SAMPLERATE\s+(\d+)", text)
+    return m.group(1), [int(v) for v in m.group(2).replace("\n", " ").split(",") if v.strip()], \
+        int(rate.group(1)) if rate else None
+
+
+def encode(samples, block):
+    out = bytearray()
+    predictor, index = 0, 0
+    decoded = []
+    for start in range(0, len(samples), block):
+        out += struct.pack("<hBB", predictor, index, 0)
+        codes = []
+        for s in samples[start:start + block] + [0] * max(0, start + block - len(samples)):
+            step = STEPS[index]
+            diff = s - predictor
+            code = 8 if diff < 0 else 0
+            diff = abs(diff)
+            delta = step >> 3
+            if diff >= step:
+                code |= 4
+                diff -= step
+                delta += step
+            step >>= 1
+            if diff >= step:
+                code |= 2
+                diff -= step
+                delta += step
+            step >>= 1
+            if diff >= step:
+                code |= 1
+                delta += step
+            predictor = max(-32768, min(32767, predictor - delta if code & 8 else predictor + delta))
+            index = max(0, min(88, index + INDEX_ADJUST[code & 7]))
+            codes.append(code)
+            decoded.append(predictor)
+        for i in range(0, block, 2):
+            out.append(codes[i] | codes[i + 1] << 4)
+    return out, decoded[:len(samples)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help=".wav or table header")
+    parser.add_argument("-o", "--output", required=True, help="header to write")
+    parser.add_argument("--name", help="table name (default: from the input)")
+    parser.add_argument("--rate", type=int, default=32768, help="sample rate to store, normally AUDIO_RATE")
+    parser.add_argument("--block", type=int, default=256, help="samples per block, a power of two")
+    args = parser.parse_args()
+
+    if args.block < 2 or args.block & (args.block - 1):
+        sys.exit("--block must be a power of two")
+    if args.input.endswith(".wav"):
+        name = args.name or os.path.splitext(os.path.basename(args.input))[0]
+        samples = read_wav(args.input, args.rate)
+        rate = args.rate
+    else:
+        table, samples, rate = read_header(args.input)
+        name = args.name or table
+        rate = rate or args.rate
+
+    data, decoded = encode(samples, args.block)
+    noise = sum((a - b) ** 2 for a, b in zip(samples, decoded))
+    signal = sum(a * a for a in samples)
+    snr = 10 * math.log10(signal / noise) if noise else float("inf")
+
+    guard = f"{name}_adpcm_H_"
+    with open(args.output, "w") as f:
+        f.write(f"#ifndef {guard}\n#define {guard}\n \n#include <Arduino.h>\n#include \"mozzi_pgmspace.h\"\n \n")
+        f.write(f"// IMA ADPCM for AdpcmSample, generated by tools/adpcm_encode.py from {os.path.basename(args.input)}\n")
+        f.write(f"#define {name}_ADPCM_SAMPLES {len(samples)}\n")
+        f.write(f"#define {name}_ADPCM_BLOCK_SAMPLES {args.block}\n")
+        f.write(f"#define {name}_ADPCM_SAMPLERATE {rate}\n")
+        f.write(f"#define {name}_ADPCM_BYTES {len(data)}\n \n")
+        f.write(f"CONSTTABLE_STORAGE(uint8_t) {name}_ADPCM [] = {{")
+        line = ""
+        for i, byte in enumerate(data):
+            item = f"{byte}, "
+            if len(line) + len(item) > 80:
+                f.write(line.rstrip() + "\n")
+                line = ""
+            line += item
+        f.write(line + "};\n\n")
+        f.write(f"#endif /* {guard} */\n")
+
+    print(f"{name}: {len(samples)} samples at {rate} Hz, {len(samples) * 2} -> {len(data)} bytes, SNR {snr:.1f} dB")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,111 @@
+// Host benchmark for the drum loop formats: the raw 16-bit loop read by mSample against the same loop as IMA ADPCM
+// (AdpcmSample in adpcm_sample.h), and TimeStretch (time_stretch.h) playing the ADPCM loop in Free mode.
+//
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/drum_bench.cpp assets.S -Wa,--noexecstack -o drum_bench && ./drum_bench
+//
+// It reports, with cycles from the time stamp counter on x86 (nanoseconds elsewhere), fastest of 8 runs of 1 s:
+//   raw, ADPCM         cycles per sample of next(), and the ADPCM loop's error against the raw one, in dB
+//   time stretch       cycles per sample of render() in the sketch's 32-sample blocks at 0.5x, 1x and 2x, and the
+//                      slowest block, which the search spread over each grain keeps close to the average
+//
+// The cycles rank the formats rather than predict the board's: the host's cache holds the whole raw loop, where the
+// ESP32 reads its 384 KB through the flash cache and the ADPCM loop's 99 KB from PSRAM.
+
+#include <Meap.h>
+
+#include "adpcm_sample.h"
+#include "assets.h"
+#include "time_stretch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t ticks() { return __rdtsc(); }
+#else
+static uint64_t ticks() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+#endif
+
+static const size_t BLOCK = 32; // the sketch's AUDIO_BLOCK_SIZE
+
+using RawLoop = mSample<neo_soul_drums_NUM_CELLS, AUDIO_RATE, int16_t>;
+using AdpcmLoop = AdpcmSample<neo_soul_drums_ADPCM_SAMPLES, neo_soul_drums_ADPCM_BLOCK_SAMPLES, AUDIO_RATE>;
+
+// Cycles per sample of source.next(), fastest of 8 runs, with the last run's output in out
+template <class Source>
+static double timeNext(Source &source, std::vector<int32_t> &out) {
+	double cycles = 1e9;
+	for (int run = 0; run < 8; ++run) {
+		source.start();
+		uint64_t start = ticks();
+		for (auto &x : out) {
+			x = source.next();
+		}
+		cycles = std::min(cycles, (double)(ticks() - start) / out.size());
+	}
+	return cycles;
+}
+
+// Energy of the difference between a and b over the energy of a, in dB, at the lag (0 or 1 samples of b behind a)
+// that matches them best
+static double errorDb(const std::vector<int32_t> &a, const std::vector<int32_t> &b) {
+	double best = INFINITY;
+	for (size_t lag = 0; lag < 2; ++lag) {
+		double signal = 0, error = 0;
+		for (size_t i = 0; i + lag < a.size(); ++i) {
+			double d = (double)a[i] - b[i + lag];
+			signal += (double)a[i] * a[i];
+			error += d * d;
+		}
+		best = std::min(best, 10 * log10(error / signal + 1e-30));
+	}
+	return best;
+}
+
+static void benchStretch(AdpcmLoop &loop, float speed) {
+	static TimeStretch<AdpcmLoop> stretch(loop);
+	stretch.setSpeed(speed);
+	int32_t buf[BLOCK];
+	double cycles = 1e9;
+	uint64_t worst = UINT64_MAX; // of the run with the mildest worst block, so an interrupt on the host doesn't count
+	for (int run = 0; run < 8; ++run) {
+		uint64_t all = 0, runWorst = 0;
+		for (size_t i = 0; i < AUDIO_RATE; i += BLOCK) {
+			uint64_t start = ticks();
+			stretch.render(buf, BLOCK);
+			uint64_t block = ticks() - start;
+			all += block;
+			runWorst = std::max(runWorst, block);
+		}
+		cycles = std::min(cycles, (double)all / AUDIO_RATE);
+		worst = std::min(worst, runWorst);
+	}
+	printf("time stretch %.1fx    %6.2f cycles/sample, worst block %llu cycles\n", speed, cycles,
+		   (unsigned long long)worst);
+}
+
+int main() {
+	static RawLoop raw(neo_soul_drums_DATA);
+	static AdpcmLoop adpcm(neo_soul_drums_ADPCM);
+	raw.setLoopingOn();
+	adpcm.setLoopingOn();
+
+	std::vector<int32_t> rawOut(AUDIO_RATE), adpcmOut(AUDIO_RATE);
+	double rawCycles = timeNext(raw, rawOut);
+	double adpcmCycles = timeNext(adpcm, adpcmOut);
+	printf("raw int16 table     %6.2f cycles/sample, %u bytes\n", rawCycles, neo_soul_drums_NUM_CELLS * 2);
+	printf("IMA ADPCM           %6.2f cycles/sample, %u bytes, error %.1f dB\n", adpcmCycles,
+		   neo_soul_drums_ADPCM_BYTES, errorDb(rawOut, adpcmOut));
+
+	const float speeds[] = {0.5f, 1, 2};
+	for (float speed : speeds) {
+		benchStretch(adpcm, speed);
+	}
+	return 0;
+}
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""Build the sketch's compiled-in samples from the .wav files in assets/.
+
+Reads assets/assets.txt, one asset per line:
+
+    <name> <source .wav> <format> [key=value ...]
+
+and writes each asset's data as a binary file in assets/build/, an assets.S that links those files in with .incbin
+(nothing is parsed by the compiler, and the object only rebuilds when an asset changes) and an assets.h that holds
+their sizes and rates and declares the data. Formats, all at rate= (default 32768, normally AUDIO_RATE):
+
+    pcm      16-bit samples as <name>_DATA, for mSample (<name>_NUM_CELLS, <name>_SAMPLERATE)
+    adpcm    IMA ADPCM blocks as <name>_ADPCM, for AdpcmSample (see adpcm_encode.py); block= samples per block
+    slices   distinct hits and pattern for SlicedDrums (see slice_drums.py); steps=, threshold=, min_gap= (ms),
+             similar=, block=
+
+The sketch's build runs it first (see the README's Sample Assets section for the arduino-cli hook), or run it by hand
+from the sketch folder, e.g. before building the host tools:
+
+    python3 tools/embed_assets.py
+
+It does nothing when the outputs are newer than assets.txt, every source it lists and these tools; --force rebuilds
+anyway. The generated files are not checked in; assets.S refers to the binaries by absolute path, since the Arduino
+build assembles it from a copy of the sketch elsewhere, and a moved sketch folder rebuilds them.
+"""
+
+import argparse
+import os
+import re
+import shlex
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import adpcm_encode  # noqa: E402
+import slice_drums  # noqa: E402
+from adpcm_encode import encode, read_wav  # noqa: E402
+from slice_drums import slice_loop  # noqa: E402
+
+SKETCH = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+class Output:
+    def __init__(self, build):
+        self.build = build
+        self.asm = []
+        self.header = []
+
+    def blob(self, symbol, ctype, data, comment):
+        path = os.path.join(self.build, symbol + ".bin")
+        with open(path, "wb") as f:
+            f.write(data)
+        self.asm += [
+            f"\t.section .rodata.{symbol}, \"a\"",
+            f"\t.global {symbol}",
+            f"\t.type {symbol}, @object",
+            "\t.balign 4",
+            f"{symbol}:",
+            f"\t.incbin \"{path}\"",
+            f"\t.size {symbol}, . - {symbol}",
+            "",
+        ]
+        self.header.append(f"extern \"C\" const {ctype} {symbol}[]; // {comment}")
+
+    def define(self, name, value):
+        self.header.append(f"#define {name} {value}")
+
+    def array(self, ctype, name, values):
+        self.header.append(f"const {ctype} {name}[] = {{{', '.join(map(str, values))}}};")
+
+
+def pcm(out, name, samples, rate, options):
+    out.define(f"{name}_NUM_CELLS", len(samples))
+    out.define(f"{name}_SAMPLERATE", rate)
+    out.blob(f"{name}_DATA", "int16_t", struct.pack(f"<{len(samples)}h", *samples), "16-bit samples")
+    return f"{len(samples) * 2} bytes"
+
+
+def adpcm(out, name, samples, rate, options):
+    block = int(options.get("block", 256))
+    if block < 2 or block & (block - 1):
+        sys.exit(f"{name}: block must be a power of two")
+    data, _ = encode(samples, block)
+    out.define(f"{name}_ADPCM_SAMPLES", len(samples))
+    out.define(f"{name}_ADPCM_BLOCK_SAMPLES", block)
+    out.define(f"{name}_ADPCM_SAMPLERATE", rate)
+    out.define(f"{name}_ADPCM_BYTES", len(data))
+    out.blob(f"{name}_ADPCM", "uint8_t", bytes(data), "IMA ADPCM blocks")
+    return f"{len(samples) * 2} -> {len(data)} bytes"
+
+
+def slices(out, name, samples, rate, options):
+    steps = int(options.get("steps", 32))
+    block = int(options.get("block", 256))
+    starts, hits, hit_of, hit_start, packed, data, hit_time = slice_loop(
+        samples, steps, float(options.get("threshold", 0.4)), int(float(options.get("min_gap", 50)) * rate / 1000),
+        float(options.get("similar", 0.9)), block)
+    out.define(f"{name}_SLICES_SAMPLES", len(packed))
+    out.define(f"{name}_SLICES_BLOCK_SAMPLES", block)
+    out.define(f"{name}_SLICES_SAMPLERATE", rate)
+    out.define(f"{name}_SLICES_BYTES", len(data))
+    out.define(f"{name}_SLICE_COUNT", len(hits))
+    out.define(f"{name}_HIT_COUNT", len(starts))
+    out.define(f"{name}_LOOP_STEPS", steps)
+    # The pattern is a few dozen numbers, so it stays in the header
+    out.array("uint32_t", f"{name}_SLICE_START", hit_start)
+    out.array("uint32_t", f"{name}_SLICE_LENGTH", [len(h) for h in hits])
+    out.array("uint32_t", f"{name}_HIT_TIME", hit_time)
+    out.array("uint8_t", f"{name}_HIT_SLICE", hit_of)
+    out.blob(f"{name}_SLICES_ADPCM", "uint8_t", bytes(data), "IMA ADPCM hits, each starting a block")
+    return f"{len(starts)} hits, {len(hits)} distinct, {len(samples) * 2} -> {len(data)} bytes"
+
+
+FORMATS = {"pcm": pcm, "adpcm": adpcm, "slices": slices}
+
+
+def up_to_date(asm, header, build, sources):
+    """True when asm and header are newer than every source and link binaries in build that are no newer than them"""
+    try:
+        built = min(os.path.getmtime(asm), os.path.getmtime(header))
+        if any(os.path.getmtime(source) > built for source in sources):
+            return False
+        with open(asm) as f:
+            binaries = re.findall(r'\.incbin "(.*)"', f.read())
+        return all(os.path.dirname(b) == build and os.path.getmtime(b) <= built for b in binaries)
+    except OSError:
+        return False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--assets", default=os.path.join(SKETCH, "assets"), help="folder with assets.txt")
+    parser.add_argument("--output", default=SKETCH, help="folder to write assets.S and assets.h to")
+    parser.add_argument("--force", action="store_true", help="rebuild even if the outputs are up to date")
+    args = parser.parse_args()
+
+    build = os.path.join(os.path.abspath(args.assets), "build")
+    listing = os.path.join(args.assets, "assets.txt")
+    entries = []
+    with open(listing) as f:
+        for number, line in enumerate(f, 1):
+            fields = shlex.split(line, comments=True)
+            if not fields:
+                continue
+            if len(fields) < 3 or fields[2] not in FORMATS:
+                sys.exit(f"assets.txt:{number}: expected <name> <source .wav> <{'|'.join(FORMATS)}> [key=value ...]")
+            entries.append(fields)
+
+    asm = os.path.join(args.output, "assets.S")
+    header = os.path.join(args.output, "assets.h")
+    sources = [listing, __file__, adpcm_encode.__file__, slice_drums.__file__]
+    sources += [os.path.join(args.assets, fields[1]) for fields in entries]
+    if not args.force and up_to_date(asm, header, build, sources):
+        print("assets up to date")
+        return
+
+    os.makedirs(build, exist_ok=True)
+    out = Output(build)
+    decoded = {}
+    for fields in entries:
+        name, source, fmt = fields[:3]
+        options = dict(field.split("=", 1) for field in fields[3:])
+        rate = int(options.get("rate", 32768))
+        key = (source, rate)
+        if key not in decoded:
+            decoded[key] = read_wav(os.path.join(args.assets, source), rate)
+        out.header.append(f"\n// {name} ({fmt}) from {source}")
+        print(f"{name} {fmt}: {FORMATS[fmt](out, name, decoded[key], rate, options)}")
+
+    with open(asm, "w") as f:
+        f.write("/* Generated by tools/embed_assets.py from assets/assets.txt, do not edit */\n\n")
+        f.write("\n".join(out.asm))
+    with open(header, "w") as f:
+        f.write("#ifndef ASSETS_H\n#define ASSETS_H\n\n#include <stdint.h>\n\n")
+        f.write("// Generated by tools/embed_assets.py from assets/assets.txt, do not edit. The data is linked in from "
+                "assets.S\n")
+        f.write("\n".join(out.header))
+        f.write("\n\n#endif\n")
+
+if __name__ == "__main__":
+    main()
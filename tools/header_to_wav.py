@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+"""Write a Mozzi-style table header out as a 16-bit mono .wav for SampleBank (sample_bank.h).
+
+Samples that used to be compiled in as `<name>_DATA [] = {...}` can move to the filesystem this way: convert them
+into the sketch's data/ folder and upload it with the LittleFS uploader. The .wav keeps the table's
+`<name>_SAMPLERATE` (or --rate when the header has none); 8-bit tables are scaled up to 16 bits.
+
+    python3 tools/header_to_wav.py landing_sample.h -o data/landing_sample.wav
+"""
+
+import argparse
+import os
+import re
+import sys
+import wave
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from adpcm_encode import read_header  # noqa: E402
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="table header")
+    parser.add_argument("-o", "--output", required=True, help=".wav to write")
+    parser.add_argument("--rate", type=int, default=32768, help="sample rate when the header doesn't define one")
+    args = parser.parse_args()
+
+    name, samples, rate = read_header(args.input)
+    if re.search(r"\bu?int8_t\s+" + name + r"_DATA", open(args.input).read()):
+        samples = [s * 256 for s in samples]
+    rate = rate or args.rate
+
+    os.makedirs(os.path.dirname(args.output) or ".", exist_ok=True)
+    with wave.open(args.output, "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(rate)
+        w.writeframes(b"".join(max(-32768, min(32767, s)).to_bytes(2, "little", signed=True) for s in samples))
+    print(f"{args.output}: {len(samples)} samples at {rate} Hz, {2 * len(samples) + 44} bytes")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,301 @@
+// Host test of the mix bus headroom proof (mix_bus.h). Each source tells the bus the magnitude bound of its output,
+// OUTPUT_BITS, and each reverb the bits its tail may add on top of its input, HEADROOM_BITS; the bus's compile-time
+// checks are only as good as those numbers. This drives every source at full scale, with the settings that push it
+// hardest, and checks the measured peak against the declared bound:
+//
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/headroom_test.cpp assets.S -Wa,--noexecstack -o headroom_test
+//     ./headroom_test
+//
+//   melody        PolyMelody with every voice held on the same note, at 24 pitches
+//   melody 2      Melody on each table and every morph step, band-limited and baked as in the sketch, 6 octaves
+//   chords        ChordVoice with every pool voice held on the same note
+//   drums         SlicedDrums at half, normal and double time, with and without swing, beat synced every beat
+//   stretch       TimeStretch of the drum loop at 0.5x, 1x and 2x
+//   resampler     Resampler over full-scale noise and full-scale squares, up and down in rate
+//   wind          Wind at full volume over a grid of cutoff and resonance, with the noise table and with full-scale
+//                 8-bit squares of several periods in its place, the worst case for a resonant peak
+//   plate, fdn N  the plate and the light reverb's tiers at the longest decay, undamped and at the sketch's
+//                 damping, for a full-scale impulse, full-scale DC of each sign and full-scale squares at the send
+//                 bus's 2^16 bound
+//
+// Each line prints the peak, the bound and the margin in dB; the run exits non-zero if any source goes over.
+// Uses the tools/host stand-ins, so the plate is the Dattorro stand-in rather than MEAP's own.
+
+#include <Meap.h>
+
+Meap meap; // phrase_model.h draws its chords from the sketch's instance
+#define AUDIO_BLOCK_SIZE 32
+#include "assets.h"
+#include "effects.h"
+#include "melody.h"
+#include "mix_bus.h"
+#include "phrase_model.h"
+#include "resampler.h"
+#include "sliced_drums.h"
+#include "time_stretch.h"
+#include "wind.h"
+#include <tables/saw8192_int16.h>
+#include <tables/sq8192_int16.h>
+#include <tables/tri8192_int16.h>
+
+#include <math.h>
+#include <stdio.h>
+
+static bool allPassed = true;
+
+// Largest magnitude seen, checked against 2^bits
+struct Peak {
+	const char *name;
+	int bits;
+	int64_t peak = 0;
+
+	Peak(const char *name, int bits) : name(name), bits(bits) {}
+
+	void add(const int32_t *buf, size_t n) {
+		for (size_t i = 0; i < n; ++i) {
+			int64_t m = buf[i] < 0 ? -(int64_t)buf[i] : buf[i];
+			peak = m > peak ? m : peak;
+		}
+	}
+
+	void add(const StereoFrame *buf, size_t n) {
+		for (size_t i = 0; i < n; ++i) {
+			add(&buf[i].l, 1);
+			add(&buf[i].r, 1);
+		}
+	}
+
+	~Peak() {
+		int64_t bound = (int64_t)1 << bits;
+		bool ok = peak <= bound;
+		allPassed = allPassed && ok;
+		printf("%-10s peak %8lld, bound 2^%d = %8lld, margin %5.1f dB  %s\n", name, (long long)peak, bits,
+			   (long long)bound, peak ? 20 * log10((double)bound / peak) : INFINITY, ok ? "ok" : "OVER");
+	}
+};
+
+// Renders seconds of source into peak, a block at a time
+template <class Source>
+static void run(Source &source, Peak &peak, float seconds) {
+	int32_t buf[AUDIO_BLOCK_SIZE];
+	for (uint32_t i = 0; i < seconds * AUDIO_RATE; i += AUDIO_BLOCK_SIZE) {
+		source.render(buf, AUDIO_BLOCK_SIZE);
+		peak.add(buf, AUDIO_BLOCK_SIZE);
+	}
+}
+
+static void testMelody() {
+	static PolyMelody<4, SINE_SMALL_CELLS, AUDIO_RATE, int16_t, true> melody(sineTable<SINE_SMALL_CELLS>());
+	Peak peak("melody", decltype(melody)::OUTPUT_BITS);
+	melody.setEnabled(true);
+	for (int note = 36; note < 108; note += 3) {
+		melody.releaseAll();
+		for (int v = 0; v < 4; ++v) {
+			melody.noteOn(note + 12 * v); // distinct notes so no voice retriggers in place
+		}
+		run(melody, peak, 0.1f);
+		melody.releaseAll();
+		for (int v = 0; v < 4; ++v) {
+			melody.noteOn(note);
+		}
+		run(melody, peak, 0.1f);
+	}
+}
+
+static void testMelody2() {
+	static Melody<sin8192_int16_NUM_CELLS, AUDIO_RATE, int16_t> melody2(sin8192_int16_DATA, "Sin");
+	Peak peak("melody 2", decltype(melody2)::OUTPUT_BITS);
+	melody2.addTable(tri8192_int16_DATA, "Tri");
+	melody2.addTable(sq8192_int16_DATA, "Sq");
+	melody2.addTable(saw8192_int16_DATA, "Saw");
+	melody2.setWave1(0);
+	melody2.setWave2(1);
+	melody2.enableMipmaps();
+	melody2.enableBakedMorph();
+	melody2.setEnabled(true);
+	melody2.setVolume(4095);
+	for (int morph = 0; morph <= 4095; morph += 128) {
+		melody2.setMorph(morph);
+		for (int note = 36; note <= 108; note += 12) {
+			melody2.setFreq(mtof(note));
+			for (int i = 0; i < 64; ++i) {
+				melody2.bakeStep();
+			}
+			run(melody2, peak, 0.02f);
+		}
+	}
+}
+
+static void testChords() {
+	static ChordVoice chords;
+	Peak peak("chords", ChordVoice::OUTPUT_BITS);
+	for (int note = 36; note < 96; note += 5) {
+		chords.releaseAll();
+		for (int v = 0; v < 8; ++v) {
+			chords.noteOn(note + v);
+		}
+		run(chords, peak, 0.1f);
+	}
+}
+
+static const DrumSliceMap slices = {neo_soul_drums_SLICE_START, neo_soul_drums_SLICE_LENGTH, neo_soul_drums_HIT_TIME,
+									neo_soul_drums_HIT_SLICE,	neo_soul_drums_HIT_COUNT,	 neo_soul_drums_LOOP_STEPS};
+
+static void testDrums() {
+	static SlicedDrums<neo_soul_drums_SLICES_SAMPLES, neo_soul_drums_SLICES_BLOCK_SAMPLES, AUDIO_RATE> drums(
+		neo_soul_drums_SLICES_ADPCM, slices);
+	Peak peak("drums", decltype(drums)::OUTPUT_BITS);
+	const uint8_t steps[] = {2, 4, 8};
+	const float swings[] = {0, 0.5f};
+	for (uint8_t s : steps) {
+		for (float swing : swings) {
+			const uint32_t beat = AUDIO_RATE / 2;
+			drums.setTempo(beat, s, swing);
+			for (int b = 0; b < 16; ++b) {
+				drums.syncBeat();
+				run(drums, peak, (float)beat / AUDIO_RATE);
+			}
+		}
+	}
+}
+
+static void testStretch() {
+	static AdpcmSample<neo_soul_drums_ADPCM_SAMPLES, neo_soul_drums_ADPCM_BLOCK_SAMPLES, AUDIO_RATE> loop(
+		neo_soul_drums_ADPCM);
+	static TimeStretch<decltype(loop)> stretch(loop);
+	Peak peak("stretch", decltype(stretch)::OUTPUT_BITS);
+	loop.setLoopingOn();
+	const float speeds[] = {0.5f, 1, 2};
+	for (float speed : speeds) {
+		stretch.setSpeed(speed);
+		run(stretch, peak, 8);
+	}
+}
+
+// Full-scale 16-bit source for the resampler: white noise, or a square of the given period in samples
+struct TestSource {
+	static constexpr int OUTPUT_BITS = 15;
+	uint32_t seed = 1;
+	uint32_t period = 0;
+	uint32_t phase = 0;
+
+	int32_t next() {
+		if (period) {
+			phase = phase + 1 == period ? 0 : phase + 1;
+			return phase < period / 2 ? 32767 : -32768;
+		}
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed & 0x80000000u ? -32768 : 32767;
+	}
+};
+
+static void testResampler() {
+	static TestSource source;
+	static Resampler<TestSource> resampler(source, AUDIO_RATE, AUDIO_RATE);
+	Peak peak("resampler", decltype(resampler)::OUTPUT_BITS);
+	const uint32_t rates[] = {8000, 16384, 22050, 44100, 48000};
+	const uint32_t periods[] = {0, 2, 3, 4, 5, 7, 16, 64};
+	for (uint32_t rate : rates) {
+		for (uint32_t period : periods) {
+			source.period = period;
+			resampler.setRates(rate, AUDIO_RATE);
+			run(resampler, peak, 0.5f);
+		}
+	}
+}
+
+static void testWind() {
+	static Wind wind;
+	static int8_t squares[4][WHITENOISE8192_NUM_CELLS];
+	const unsigned int periods[] = {8, 32, 128, 1024}; // table cells; the wind reads a cell every 4 samples
+	Peak peak("wind", Wind::OUTPUT_BITS);
+	wind.setEnabled(true);
+	wind.setVolume(4095);
+	for (int t = 0; t <= 4; ++t) {
+		if (t < 4) {
+			for (unsigned int i = 0; i < WHITENOISE8192_NUM_CELLS; ++i) {
+				squares[t][i] = i % periods[t] < periods[t] / 2 ? 127 : -128;
+			}
+			wind.setNoiseTable(squares[t]);
+		} else {
+			wind.setNoiseTable(WHITENOISE8192_DATA);
+		}
+		for (int cutoff = 0; cutoff <= 255; cutoff += 15) {
+			for (int resonance = 0; resonance <= 255; resonance += 15) {
+				wind.setCutOffAndResonance(cutoff, resonance);
+				run(wind, peak, 0.1f);
+			}
+		}
+	}
+}
+
+static const int ReverbSendBits = 16; // the sketch's SendBus<16, ...> clamps the reverb's input here
+
+// Full-scale input at sample i: an impulse, DC of each sign, then squares of a few periods
+static int32_t reverbInput(int phase, uint32_t i) {
+	const int32_t FULL = 1 << ReverbSendBits;
+	const uint32_t periods[] = {32, 128, 512, 4096};
+	switch (phase) {
+	case 0:
+		return i == 0 ? FULL : 0;
+	case 1:
+		return FULL;
+	case 2:
+		return -FULL;
+	default:
+		return i % periods[phase - 3] < periods[phase - 3] / 2 ? FULL : -FULL;
+	}
+}
+
+// Every reverbInput() phase for 4 s through a reverb at its longest decay
+template <class Reverb>
+static void driveReverb(Reverb &reverb, Peak &peak) {
+	int32_t in[AUDIO_BLOCK_SIZE];
+	StereoFrame out[AUDIO_BLOCK_SIZE];
+	const float dampings[] = {0, 0.8f};
+	for (float damping : dampings) {
+		reverb.setDamping(damping);
+		for (int phase = 0; phase < 7; ++phase) {
+			for (uint32_t i = 0; i < 4 * AUDIO_RATE; i += AUDIO_BLOCK_SIZE) {
+				for (size_t k = 0; k < AUDIO_BLOCK_SIZE; ++k) {
+					in[k] = reverbInput(phase, i + k);
+				}
+				reverb.render(in, out, AUDIO_BLOCK_SIZE);
+				peak.add(out, AUDIO_BLOCK_SIZE);
+			}
+		}
+	}
+}
+
+template <unsigned int LINES>
+static void testFdn(const char *name) {
+	static LightReverb<LINES> reverb(1.0f, 0, 1.0f, 1.0f);
+	Peak peak(name, ReverbSendBits + decltype(reverb)::HEADROOM_BITS);
+	reverb.setEnabled(true);
+	driveReverb(reverb, peak);
+}
+
+static void testPlate() {
+	static Reverb<> reverb(1.0f, 0, 1.0f, 1.0f);
+	Peak peak("plate", ReverbSendBits + decltype(reverb)::HEADROOM_BITS);
+	reverb.setEnabled(true);
+	reverb.setDecay(1.0f);
+	driveReverb(reverb, peak);
+}
+
+int main() {
+	testMelody();
+	testMelody2();
+	testChords();
+	testDrums();
+	testStretch();
+	testResampler();
+	testWind();
+	testPlate();
+	testFdn<4>("fdn 4");
+	testFdn<8>("fdn 8");
+	testFdn<16>("fdn 16");
+	return allPassed ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Linux stand-in for the parts of the Arduino core the sketch uses, so it builds as a host program
+// (tools/render_offline.cpp). Time is virtual: millis() and micros() follow the audio frames rendered so far, which
+// the host program advances with hostAdvance(), so a render is repeatable and runs as fast as the CPU allows.
+// Serial writes to hostSerialOut, stdout unless the host program points it elsewhere, or nowhere when it is null.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#define ARDUINO 10819
+#define PI 3.1415926535897932384626433832795
+#define SERIAL_8N1 0x800001c
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// Audio frames rendered so far, the clock behind millis(), micros() and Mozzi's audioTicks()
+inline uint64_t hostFrames = 0;
+inline const unsigned long hostRate = 32768; // AUDIO_RATE, which Meap.h checks
+
+inline void hostAdvance(size_t frames) { hostFrames += frames; }
+
+inline unsigned long micros() { return (unsigned long)(hostFrames * 1000000 / hostRate); }
+inline unsigned long millis() { return (unsigned long)(hostFrames * 1000 / hostRate); }
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+
+class String {
+  private:
+	std::string s;
+
+  public:
+	String() {}
+	String(const char *c) : s(c ? c : "") {}
+	String(const std::string &c) : s(c) {}
+	String(char c) : s(1, c) {}
+	String(int v) : s(std::to_string(v)) {}
+	String(unsigned int v) : s(std::to_string(v)) {}
+	String(long v) : s(std::to_string(v)) {}
+	String(unsigned long v) : s(std::to_string(v)) {}
+	String(double v, int decimals = 2) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+		s = buf;
+	}
+
+	int indexOf(const char *c) const {
+		size_t p = s.find(c);
+		return p == std::string::npos ? -1 : (int)p;
+	}
+	int indexOf(const String &c) const { return indexOf(c.c_str()); }
+	unsigned int length() const { return s.size(); }
+	const char *c_str() const { return s.c_str(); }
+
+	String &operator+=(const String &o) {
+		s += o.s;
+		return *this;
+	}
+	friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+	bool operator==(const String &o) const { return s == o.s; }
+	bool operator!=(const String &o) const { return s != o.s; }
+};
+
+// Arduino's Print formatting: integers in base 10, floating point with 2 decimals unless told otherwise
+class Print {
+  private:
+	size_t out(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+
+	template <class I>
+	size_t outInt(I v) {
+		return out(std::to_string(v).c_str());
+	}
+
+  protected:
+	virtual FILE *file() = 0;
+
+  public:
+	virtual ~Print() {}
+
+	size_t print(const char *v) { return out(v); }
+	size_t print(const String &v) { return out(v.c_str()); }
+	size_t print(char v) { return write((const uint8_t *)&v, 1); }
+	size_t print(int v) { return outInt(v); }
+	size_t print(unsigned int v) { return outInt(v); }
+	size_t print(long v) { return outInt(v); }
+	size_t print(unsigned long v) { return outInt(v); }
+	size_t print(long long v) { return outInt(v); }
+	size_t print(unsigned long long v) { return outInt(v); }
+	size_t print(double v, int decimals = 2) { return out(String(v, decimals).c_str()); }
+
+	template <class X>
+	size_t println(const X &v) {
+		return print(v) + println();
+	}
+	size_t println(double v, int decimals) { return print(v, decimals) + println(); }
+	size_t println() { return out("\r\n"); }
+
+	int printf(const char *format, ...) {
+		char buf[256];
+		va_list args;
+		va_start(args, format);
+		int n = vsnprintf(buf, sizeof(buf), format, args);
+		va_end(args);
+		out(buf);
+		return n;
+	}
+
+	size_t write(uint8_t c) { return print((char)c); }
+	size_t write(const uint8_t *buf, size_t n) { return file() ? fwrite(buf, 1, n, file()) : n; }
+	int availableForWrite() { return 128; }
+	void flush() {
+		if (file())
+			fflush(file());
+	}
+};
+
+inline FILE *hostSerialOut = stdout;
+
+class HardwareSerial : public Print {
+  private:
+	FILE **target;
+
+  protected:
+	FILE *file() override { return *target; }
+
+  public:
+	explicit HardwareSerial(FILE **target) : target(target) {}
+	void begin(unsigned long) {}
+	void begin(unsigned long, uint32_t, int8_t, int8_t) {}
+	int available() { return 0; }
+	int read() { return -1; }
+	explicit operator bool() { return true; }
+};
+
+inline FILE *hostSerial1Out = nullptr; // MIDI out; nothing listens on the host
+
+inline HardwareSerial Serial(&hostSerialOut);
+inline HardwareSerial Serial1(&hostSerial1Out);
+
+#endif
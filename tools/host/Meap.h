@@ -0,0 +1,270 @@
+#ifndef HOST_MEAP_H
+#define HOST_MEAP_H
+
+// Linux stand-in for the MEAP library and the Mozzi modules the sketch uses, for tools/render_offline.cpp and the
+// other host tools. The oscillator, sample, filter and timing classes follow Mozzi's own fixed-point arithmetic, so
+// the sketch's audio objects run on the host as they do on the board. The plate reverb is a plain Dattorro plate
+// with the same controls, not MEAP's code: close enough to time and to check headroom against, but not the board's
+// exact sound. Inputs don't poll anything; the host program sets pot_vals and volume_val and calls updateTouch() and
+// updateDip() itself.
+
+#include <Arduino.h>
+
+#define AUDIO_RATE 32768
+#define MOZZI_AUDIO_RATE AUDIO_RATE
+#define CONTROL_RATE_DEFAULT 64
+
+static_assert(AUDIO_RATE == hostRate, "the host clock runs at AUDIO_RATE");
+
+// Audio frames played so far
+inline unsigned long audioTicks() { return (unsigned long)hostFrames; }
+
+inline void startMozzi(int) {}
+inline void audioHook() {}
+
+struct AudioOutput {
+	int32_t l, r;
+};
+typedef AudioOutput AudioOutput_t;
+
+struct StereoOutput {
+	// Mozzi scales an N-bit sample to the DAC; the host keeps the N bits
+	static AudioOutput fromNBit(int, int32_t l, int32_t r) { return {l, r}; }
+};
+
+#define MIDI_CREATE_INSTANCE(Type, SerialPort, Name) struct HostMidi##Name { } Name;
+
+// Note to frequency, as Mozzi's mtof(): exact for a float note, whole hertz for an integer one
+inline float mtof(float note) { return note > 0 ? 8.1757989156f * powf(2.0f, note / 12.0f) : 0; }
+inline int mtof(int note) { return (int)mtof((float)note); }
+inline int mtof(uint8_t note) { return mtof((int)note); }
+
+// Wavetable oscillator: Q16.16 phase, table index from the integer part, as Mozzi's Oscil
+template <unsigned int NUM_CELLS, unsigned int UPDATE_RATE, class T = int8_t>
+class mOscil {
+	static_assert((NUM_CELLS & (NUM_CELLS - 1)) == 0, "NUM_CELLS must be a power of two");
+
+  private:
+	static const int F_BITS = 16;
+	const T *table;
+	uint32_t phase = 0;
+	uint32_t increment = 0;
+
+  public:
+	mOscil(const T *table_data = nullptr) : table(table_data) {}
+
+	void setTable(const T *table_data) { table = table_data; }
+
+	void setPhase(unsigned int cell) { phase = (uint32_t)cell << F_BITS; }
+
+	void setFreq(int freq) { increment = (uint32_t)(((uint64_t)NUM_CELLS * freq << F_BITS) / UPDATE_RATE); }
+
+	void setFreq(float freq) { increment = (uint32_t)((float)NUM_CELLS * freq / UPDATE_RATE * (1 << F_BITS)); }
+
+	T next() {
+		phase += increment;
+		return table[(phase >> F_BITS) & (NUM_CELLS - 1)];
+	}
+};
+
+// Sample player: 16 fractional bits of position in a 64-bit phase so long samples fit, as MEAP's mSample. Plays at
+// its stored rate until setSpeed() or setFreq() says otherwise
+template <unsigned int NUM_CELLS, unsigned int UPDATE_RATE, class T = int8_t>
+class mSample {
+  private:
+	static const int F_BITS = 16;
+	const T *table;
+	uint64_t phase = 0;
+	uint64_t increment = 1ull << F_BITS;
+	bool looping = false;
+
+  public:
+	mSample(const T *table_data) : table(table_data) {}
+
+	void setTable(const T *table_data) { table = table_data; }
+	void setLoopingOn() { looping = true; }
+	void setLoopingOff() { looping = false; }
+	void start() { phase = 0; }
+	bool isPlaying() { return phase < ((uint64_t)NUM_CELLS << F_BITS); }
+
+	// Playback rate relative to the stored rate
+	void setSpeed(float speed) { increment = (uint64_t)(speed * (1 << F_BITS)); }
+
+	// Times the whole sample repeats per second
+	void setFreq(float freq) { increment = (uint64_t)((float)NUM_CELLS * freq / UPDATE_RATE * (1 << F_BITS)); }
+
+	T next() {
+		const uint64_t end = (uint64_t)NUM_CELLS << F_BITS;
+		if (phase >= end) {
+			if (!looping)
+				return 0;
+			phase -= end;
+		}
+		T out = table[phase >> F_BITS];
+		phase += increment;
+		return out;
+	}
+};
+
+// Timer on the audio clock, as Mozzi's EventDelay
+class EventDelay {
+  private:
+	unsigned long ticks = 0;
+	unsigned long deadline = 0;
+
+  public:
+	EventDelay(unsigned int ms = 0) { set(ms); }
+
+	void set(unsigned int ms) { ticks = (unsigned long)(ms * (AUDIO_RATE / 1000.0f)); }
+
+	void start() { deadline = audioTicks() + ticks; }
+
+	void start(unsigned int ms) {
+		set(ms);
+		start();
+	}
+
+	bool ready() { return audioTicks() >= deadline; }
+};
+
+// Two-pole resonant filter with every output tapped, as Mozzi's MultiResonantFilter: cutoff and resonance in the
+// full range of su, state in 32 bits like AudioOutputStorage_t on the board
+template <class su = uint8_t>
+class MultiResonantFilter {
+  private:
+	static const int FX_SHIFT = sizeof(su) * 8;
+	static const uint32_t SHIFTED_1 = (1u << FX_SHIFT) - 1;
+
+	su q = 0;
+	su f = 0;
+	uint32_t fb = 0;
+	int32_t buf0 = 0, buf1 = 0;
+	int32_t last = 0;
+
+	static int32_t fxmul(int64_t a, int64_t b) { return (int32_t)((a * b) >> FX_SHIFT); }
+
+  public:
+	void setCutoffFreq(su cutoff) {
+		f = cutoff;
+		fb = q + (((uint32_t)q * (SHIFTED_1 - cutoff)) >> FX_SHIFT);
+	}
+
+	void setResonance(su resonance) { q = resonance; }
+
+	void setCutoffFreqAndResonance(su cutoff, su resonance) {
+		q = resonance;
+		setCutoffFreq(cutoff);
+	}
+
+	void next(int32_t in) {
+		last = in;
+		buf0 += fxmul((in - buf0) + fxmul(fb, buf0 - buf1), f);
+		buf1 += fxmul(buf0 - buf1, f);
+	}
+
+	int32_t low() { return buf1; }
+	int32_t high() { return last - buf0; }
+	int32_t band() { return buf0 - buf1; }
+	int32_t notch() { return last - buf0 + buf1; }
+};
+
+// Plate reverb after Dattorro, "Effect Design Part 1" (1997): input bandwidth filter and diffusers, then a
+// figure-eight tank of two allpass-delay-damping-delay loops, tapped for a mono output. Lengths are scaled from the
+// paper's 29761 Hz to AUDIO_RATE. decay is the tank's loop gain, held to 0.95 so the tail always dies away as in
+// embedded ports of the plate; damping and bandwidth are its one-pole coefficients, mix the wet share of the output
+template <class T = int32_t>
+class mPlateReverb {
+  private:
+	template <unsigned int PAPER_LENGTH>
+	struct Line {
+		static constexpr unsigned int LENGTH = (unsigned int)(PAPER_LENGTH * (double)AUDIO_RATE / 29761 + 0.5);
+		float cells[LENGTH] = {};
+		unsigned int pos = 0;
+
+		// The sample written LENGTH samples ago, or tap samples ago
+		float read() const { return cells[pos]; }
+		float tap(unsigned int paperTap) const {
+			unsigned int back = (unsigned int)(paperTap * (double)AUDIO_RATE / 29761 + 0.5);
+			return cells[(pos + LENGTH - back) % LENGTH];
+		}
+		void write(float x) {
+			cells[pos] = x;
+			pos = pos + 1 == LENGTH ? 0 : pos + 1;
+		}
+		float allpass(float x, float gain) {
+			float d = read();
+			float v = x - gain * d;
+			write(v);
+			return d + gain * v;
+		}
+	};
+
+	Line<142> in1;
+	Line<107> in2;
+	Line<379> in3;
+	Line<277> in4;
+	Line<672> apL;
+	Line<4453> delayL1;
+	Line<1800> apL2;
+	Line<3720> delayL2;
+	Line<908> apR;
+	Line<4217> delayR1;
+	Line<2656> apR2;
+	Line<3163> delayR2;
+	float bandState = 0, dampL = 0, dampR = 0;
+	float decay, damping, bandwidth, mix;
+
+  public:
+	mPlateReverb(float decay = 0.5, float damping = 0.5, float bandwidth = 0.9995, float mix = 0.5)
+		: decay(decay), damping(damping), bandwidth(bandwidth), mix(mix) {}
+
+	void setDecay(float d) { decay = constrain(d, 0.0f, 0.95f); }
+	void setDamping(float d) { damping = constrain(d, 0.0f, 1.0f); }
+	void setBandwidth(float b) { bandwidth = constrain(b, 0.0f, 1.0f); }
+	void setMix(float m) { mix = constrain(m, 0.0f, 1.0f); }
+
+	T next(T input) {
+		float x = (float)input;
+		bandState += bandwidth * (x - bandState);
+		float d = in4.allpass(in3.allpass(in2.allpass(in1.allpass(bandState, 0.75f), 0.75f), 0.625f), 0.625f);
+
+		float left = apL.allpass(d + decay * delayR2.read(), -0.7f);
+		float right = apR.allpass(d + decay * delayL2.read(), -0.7f);
+		delayL1.write(left);
+		delayR1.write(right);
+		dampL += (1 - damping) * (delayL1.read() - dampL);
+		dampR += (1 - damping) * (delayR1.read() - dampR);
+		delayL2.write(apL2.allpass(decay * dampL, 0.5f));
+		delayR2.write(apR2.allpass(decay * dampR, 0.5f));
+
+		float wet = 0.6f * (delayR1.tap(266) + delayR1.tap(2974) - apR2.tap(1913) + delayR2.tap(1996) -
+							delayL1.tap(1990) - apL2.tap(187) - delayL2.tap(1066));
+		return (T)lrintf(x + mix * (wet - x));
+	}
+};
+
+// Board inputs as the sketch reads them
+class Meap {
+  private:
+	uint32_t seed = 0x9e3779b9u;
+
+  public:
+	static const int MEAP_MIDI_IN_PIN = 43;
+	static const int MEAP_MIDI_OUT_PIN = 44;
+
+	int pot_vals[2] = {0, 0}; // 0-4095
+	int volume_val = 4095;
+
+	void begin() {}
+	void readInputs() {}
+
+	// Uniform integer from low to high inclusive, from a fixed seed so renders repeat
+	long irand(long low, long high) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return low + (long)(seed % (uint32_t)(high - low + 1));
+	}
+};
+
+#endif
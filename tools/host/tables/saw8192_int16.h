@@ -0,0 +1,18 @@
+#ifndef SAW8192_INT16_H_
+#define SAW8192_INT16_H_
+
+#include <Arduino.h>
+
+#define saw8192_int16_NUM_CELLS 8192
+#define saw8192_int16_SAMPLERATE 8192
+
+// One cycle of a full-scale rising sawtooth, computed at startup on the host rather than stored
+inline int16_t saw8192_int16_DATA[saw8192_int16_NUM_CELLS];
+inline const bool saw8192_int16_READY = [] {
+	for (int i = 0; i < saw8192_int16_NUM_CELLS; ++i) {
+		saw8192_int16_DATA[i] = (int16_t)(i * 65536 / saw8192_int16_NUM_CELLS - 32768);
+	}
+	return true;
+}();
+
+#endif
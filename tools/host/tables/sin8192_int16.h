@@ -0,0 +1,18 @@
+#ifndef SIN8192_INT16_H_
+#define SIN8192_INT16_H_
+
+#include <Arduino.h>
+
+#define sin8192_int16_NUM_CELLS 8192
+#define sin8192_int16_SAMPLERATE 8192
+
+// One cycle of a full-scale sine, computed at startup on the host rather than stored
+inline int16_t sin8192_int16_DATA[sin8192_int16_NUM_CELLS];
+inline const bool sin8192_int16_READY = [] {
+	for (int i = 0; i < sin8192_int16_NUM_CELLS; ++i) {
+		sin8192_int16_DATA[i] = (int16_t)lrint(32767 * sin(2 * PI * i / sin8192_int16_NUM_CELLS));
+	}
+	return true;
+}();
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef SQ8192_INT16_H_
+#define SQ8192_INT16_H_
+
+#include <Arduino.h>
+
+#define sq8192_int16_NUM_CELLS 8192
+#define sq8192_int16_SAMPLERATE 8192
+
+// One cycle of a full-scale square, computed at startup on the host rather than stored
+inline int16_t sq8192_int16_DATA[sq8192_int16_NUM_CELLS];
+inline const bool sq8192_int16_READY = [] {
+	for (int i = 0; i < sq8192_int16_NUM_CELLS; ++i) {
+		sq8192_int16_DATA[i] = i < sq8192_int16_NUM_CELLS / 2 ? 32767 : -32768;
+	}
+	return true;
+}();
+
+#endif
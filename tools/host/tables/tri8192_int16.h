@@ -0,0 +1,19 @@
+#ifndef TRI8192_INT16_H_
+#define TRI8192_INT16_H_
+
+#include <Arduino.h>
+
+#define tri8192_int16_NUM_CELLS 8192
+#define tri8192_int16_SAMPLERATE 8192
+
+// One cycle of a full-scale triangle from zero upwards, computed at startup on the host rather than stored
+inline int16_t tri8192_int16_DATA[tri8192_int16_NUM_CELLS];
+inline const bool tri8192_int16_READY = [] {
+	for (int i = 0; i < tri8192_int16_NUM_CELLS; ++i) {
+		int32_t v = i < 2048 ? i * 16 : (i < 6144 ? 65536 - i * 16 : i * 16 - 131072);
+		tri8192_int16_DATA[i] = (int16_t)(v > 32767 ? 32767 : v);
+	}
+	return true;
+}();
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef WHITENOISE8192_INT8_H_
+#define WHITENOISE8192_INT8_H_
+
+#include <Arduino.h>
+
+#define WHITENOISE8192_NUM_CELLS 8192
+#define WHITENOISE8192_SAMPLERATE 8192
+
+// 8-bit white noise from a fixed seed, computed at startup on the host rather than stored
+inline int8_t WHITENOISE8192_DATA[WHITENOISE8192_NUM_CELLS];
+inline const bool WHITENOISE8192_READY = [] {
+	uint32_t seed = 0x2545f491u;
+	for (int i = 0; i < WHITENOISE8192_NUM_CELLS; ++i) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		WHITENOISE8192_DATA[i] = (int8_t)(seed >> 24);
+	}
+	return true;
+}();
+
+#endif
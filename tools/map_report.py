@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""Report where the audio path's code and tables landed in an ESP32 build.
+
+Parses the GNU ld map the ESP32 Arduino core writes next to the firmware (acmc_final.ino.map in the sketch's build
+directory; `arduino-cli compile --export-binaries` or Sketch > Export Compiled Binary puts it in build/) and prints,
+for every symbol matching one of the patterns, whether it sits in IRAM, DRAM, PSRAM or flash, plus totals per
+region. Hot code still listed under FLASH is read through the cache at audio time; the sample and noise tables stay
+listed there because placeTable() copies them into RAM at runtime.
+
+    python3 tools/map_report.py build/esp32.esp32.esp32s3/acmc_final.ino.map
+    python3 tools/map_report.py acmc_final.ino.map --pattern 'Reverb' --pattern 'sin8192'
+"""
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+from collections import defaultdict
+
+# Symbols the audio path touches every block
+HOT_PATTERNS = [
+    r"updateAudio",
+    r"renderBlock",
+    r"render\w*Node",
+    r"::render\(",
+    r"::next\(",
+    r"interpolateCell",
+    r"sin8192_int16_DATA",
+    r"whitenoise_data",
+    r"neo_soul_drums_\w+",
+    r"\bannouncements\b",
+    r"sineTable",
+    r"\bchorus\b",
+    r"\breverb\b",
+    r"\bchordVoice\b",
+    r"\bmelody2?\b",
+    r"\bwind\b",
+    r"\bmixBlock\b",
+    r"\bscratchBlock\b",
+]
+
+OUTPUT_SECTION = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?\s*$")
+INPUT_SECTION = re.compile(r"^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*))?$")
+INPUT_CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*)$")
+SYMBOL = re.compile(r"^\s{16,}0x([0-9a-fA-F]+)\s+([^\s0].*)$")
+
+
+def region_of(section):
+    name = section.lower()
+    if "iram" in name:
+        return "IRAM"
+    if "ext_ram" in name or "psram" in name:
+        return "PSRAM"
+    if "dram" in name:
+        return "DRAM"
+    if "flash" in name or name.startswith(".irom") or name.startswith(".drom"):
+        return "FLASH"
+    if "rtc" in name:
+        return "RTC"
+    return "OTHER"
+
+
+def parse_map(lines):
+    """Yields (output section, input section, address, size, symbols) for every input section with a size."""
+    in_map = False
+    output = None
+    pending = None  # input section whose address and size are on the next line
+    current = None
+
+    def flush():
+        if current is not None and current[3] > 0:
+            yield tuple(current)
+
+    for line in lines:
+        line = line.rstrip("\n")
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+
+        m = OUTPUT_SECTION.match(line)
+        if m:
+            yield from flush()
+            current = None
+            output = m.group(1)
+            continue
+        if output is None:
+            continue
+
+        if pending is not None:
+            m = INPUT_CONTINUATION.match(line)
+            if m:
+                current = [output, pending, int(m.group(1), 16), int(m.group(2), 16), []]
+                pending = None
+                continue
+            pending = None
+
+        m = INPUT_SECTION.match(line)
+        if m and not line.startswith("  "):
+            yield from flush()
+            current = None
+            if m.group(2) is None:
+                pending = m.group(1)
+            else:
+                current = [output, m.group(1), int(m.group(2), 16), int(m.group(3), 16), []]
+            continue
+
+        m = SYMBOL.match(line)
+        if m and current is not None:
+            current[4].append(m.group(2).strip())
+
+    yield from flush()
+
+
+def demangler():
+    if shutil.which("c++filt") is None:
+        return lambda names: names
+    def demangle(names):
+        if not names:
+            return names
+        result = subprocess.run(["c++filt"], input="\n".join(names), capture_output=True, text=True)
+        return result.stdout.splitlines() if result.returncode == 0 else names
+    return demangle
+
+
+def section_symbol(input_section):
+    # -ffunction-sections / -fdata-sections name input sections after their symbol: .text._Z11renderBlockPij
+    for prefix in (".text.", ".rodata.", ".data.", ".bss.", ".literal."):
+        if input_section.startswith(prefix):
+            return input_section[len(prefix):]
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map", help="linker map file")
+    parser.add_argument("--pattern", action="append", help="regex on demangled names (repeatable; default: hot path)")
+    parser.add_argument("--all", action="store_true", help="list every match, not only the first per name")
+    args = parser.parse_args()
+
+    patterns = [re.compile(p) for p in (args.pattern or HOT_PATTERNS)]
+
+    with open(args.map, errors="replace") as f:
+        sections = list(parse_map(f))
+
+    names = []
+    for output, input_section, address, size, symbols in sections:
+        names.extend(symbols)
+        derived = section_symbol(input_section)
+        if derived:
+            names.append(derived)
+    demangled = dict(zip(names, demangler()(names)))
+
+    totals = defaultdict(int)
+    rows = []
+    seen = set()
+    for output, input_section, address, size, symbols in sections:
+        region = region_of(output)
+        totals[region] += size
+        candidates = symbols or ([section_symbol(input_section)] if section_symbol(input_section) else [])
+        for symbol in candidates:
+            name = demangled.get(symbol, symbol)
+            if not any(p.search(name) for p in patterns):
+                continue
+            if name in seen and not args.all:
+                continue
+            seen.add(name)
+            rows.append((region, output, address, size, name))
+
+    order = {"FLASH": 0, "PSRAM": 1, "DRAM": 2, "IRAM": 3, "RTC": 4, "OTHER": 5}
+    rows.sort(key=lambda r: (order[r[0]], r[4]))
+    print(f"{'region':<6} {'section':<18} {'address':>10} {'size':>8}  symbol")
+    for region, output, address, size, name in rows:
+        print(f"{region:<6} {output:<18} {address:#010x} {size:>8}  {name}")
+
+    print()
+    for region in sorted(totals, key=lambda r: order[r]):
+        print(f"{region:<6} {totals[region]:>9} bytes")
+    in_flash = sum(1 for r in rows if r[0] == "FLASH")
+    if in_flash:
+        # Tables copied by placeTable() still show their flash original here; only code and unplaced tables matter
+        print(f"\n{in_flash} hot symbol(s) in flash; *_DATA tables placed at setup() are expected", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
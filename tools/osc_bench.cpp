@@ -0,0 +1,75 @@
+// Host benchmark for the sine oscillators: the 8192-cell table read by truncation (Mozzi's Oscil) against the 2048-
+// and 1024-cell tables read with linear interpolation (InterpOscil in osc_bank.h) that the chord and melody voices use.
+//
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/osc_bench.cpp -o osc_bench && ./osc_bench
+//
+// For each oscillator and tone it reports:
+//   cycles     per sample, from the time stamp counter on x86 (nanoseconds elsewhere), fastest of 8 runs of 1 s
+//   THD+N      everything but the tone, relative to it: the energy left after a least-squares fit of the ideal sine,
+//              over the first 4096 samples so the rounding of the frequency to the phase increment hardly shows
+//
+// The tables are the tools/host stand-ins, computed the way Mozzi's are, so THD+N matches the board's; the cycles
+// only rank the oscillators, since the host's cache holds all three tables where the ESP32 reads the 8192-cell one
+// through its flash cache.
+
+#include <Meap.h>
+
+#include "osc_bank.h"
+#include "sine_tables.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t ticks() { return __rdtsc(); }
+#else
+static uint64_t ticks() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+#endif
+
+// Energy of the first n samples of x outside a least-squares fit of a sine at freq, over the fitted energy, in dB
+static double thdN(const std::vector<int32_t> &x, size_t n, double freq) {
+	double ss = 0, sc = 0, cc = 0, xs = 0, xc = 0, xx = 0;
+	double w = 2 * M_PI * freq / AUDIO_RATE;
+	for (size_t i = 0; i < n; ++i) {
+		double s = sin(w * (i + 1)), c = cos(w * (i + 1)); // next() steps the phase before reading
+		ss += s * s, sc += s * c, cc += c * c;
+		xs += x[i] * s, xc += x[i] * c, xx += (double)x[i] * x[i];
+	}
+	double det = ss * cc - sc * sc;
+	double fitted = ((xs * cc - xc * sc) * xs + (xc * ss - xs * sc) * xc) / det;
+	return 10 * log10((xx - fitted) / fitted + 1e-30);
+}
+
+template <class Osc>
+static void bench(const char *name, Osc &osc, double freq) {
+	std::vector<int32_t> tone(AUDIO_RATE);
+	double cycles = 1e9;
+	for (int run = 0; run < 8; ++run) {
+		osc.setFreq((float)freq);
+		uint64_t start = ticks();
+		for (auto &x : tone) {
+			x = osc.next();
+		}
+		cycles = std::min(cycles, (double)(ticks() - start) / tone.size());
+	}
+	printf("%-26s %7.1f Hz  %6.2f cycles  THD+N %6.1f dB\n", name, freq, cycles, thdN(tone, 4096, freq));
+}
+
+int main() {
+	const double freqs[] = {103.7, 441.3, 1767.1, 7013.9}; // off the table grid, so truncation shows
+	for (double freq : freqs) {
+		mOscil<sin8192_int16_NUM_CELLS, AUDIO_RATE, int16_t> sine8192(sin8192_int16_DATA);
+		InterpOscil<2048, AUDIO_RATE, int16_t> sine2048(sineTable<2048>());
+		InterpOscil<1024, AUDIO_RATE, int16_t> sine1024(sineTable<1024>());
+		bench("8192 cells, truncated", sine8192, freq);
+		bench("2048 cells, interpolated", sine2048, freq);
+		bench("1024 cells, interpolated", sine1024, freq);
+	}
+	return 0;
+}
@@ -0,0 +1,135 @@
+// Renders the sketch on the host, through its own renderBlock(), to a 16-bit stereo .wav, and reports the render
+// speed and each stage's share of it. The Arduino, MEAP and Mozzi parts come from the stand-ins in tools/host; the
+// rest is the sketch as it builds for the board, so audio changes can be heard and timed without flashing.
+//
+//     g++ -O2 -std=c++17 -Itools/host tools/render_offline.cpp assets.S -Wa,--noexecstack -o render_offline
+//     ./render_offline 30 cabin.wav
+//
+// Arguments: seconds to render (default 30) and the output file (default render.wav). The run follows a fixed cue
+// list on a virtual clock, so every run renders the same audio: all modules on, chorus with a dotted-eighth delay,
+// plate reverb, a 500 ms sixteenth, and the performance started. The clock is AUDIO_RATE frames per second of audio
+// whatever the host's speed, and updateControl() runs every AUDIO_RATE / CONTROL_RATE frames as Mozzi would call it.
+// The sketch's Serial output is discarded; set SERIAL_OUT=1 in the environment to see it. Announcements stream from
+// data/ under the working directory when it has them, and are silent otherwise.
+
+#define OFFLINE_RENDER 1
+#include "../acmc_final.ino"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+static_assert(!DUAL_CORE, "the offline render drives control and audio from one thread");
+
+static const unsigned long FRAMES_PER_CONTROL = AUDIO_RATE / CONTROL_RATE;
+
+static void writeLe(FILE *f, uint32_t v, int bytes) {
+	for (int i = 0; i < bytes; ++i) {
+		fputc((v >> (8 * i)) & 0xff, f);
+	}
+}
+
+static void writeWavHeader(FILE *f, uint32_t frames) {
+	uint32_t dataBytes = frames * 4;
+	fwrite("RIFF", 1, 4, f);
+	writeLe(f, 36 + dataBytes, 4);
+	fwrite("WAVEfmt ", 1, 8, f);
+	writeLe(f, 16, 4);
+	writeLe(f, 1, 2); // PCM
+	writeLe(f, 2, 2); // stereo
+	writeLe(f, AUDIO_RATE, 4);
+	writeLe(f, AUDIO_RATE * 4, 4);
+	writeLe(f, 4, 2);
+	writeLe(f, 16, 2);
+	fwrite("data", 1, 4, f);
+	writeLe(f, dataBytes, 4);
+}
+
+// Selects a pad's pot mode, sets both pots and lets one control tick read them
+static void cue(int pad, int pot0, int pot1) {
+	meap.pot_vals[0] = pot0;
+	meap.pot_vals[1] = pot1;
+	updateTouch(pad, true);
+	updateTouch(pad, false);
+	updateControl();
+}
+
+int main(int argc, char **argv) {
+	double seconds = argc > 1 ? atof(argv[1]) : 30;
+	const char *path = argc > 2 ? argv[2] : "render.wav";
+	const char *serialOut = getenv("SERIAL_OUT");
+	hostSerialOut = serialOut && atoi(serialOut) ? stdout : nullptr;
+
+	FILE *wav = fopen(path, "wb");
+	if (!wav) {
+		perror(path);
+		return 1;
+	}
+
+	setup();
+	for (int dip = 0; dip < 7; ++dip) {
+		updateDip(dip, true);
+	}
+	cue(1, 1600, 2000); // chorus at about 2 Hz, half depth
+	updateTouch(1, true); // pad 1 again: dotted-eighth delay
+	updateTouch(1, false);
+	cue(2, 2800, 1800); // reverb decay and return level
+	cue(0, 0, 862);		// straight time, sixteenthLength 499 ms
+	updateTouch(5, true); // start the performance
+	updateTouch(5, false);
+
+	const uint32_t totalFrames = (uint32_t)(seconds * AUDIO_RATE) / AUDIO_BLOCK_SIZE * AUDIO_BLOCK_SIZE;
+	writeWavHeader(wav, totalFrames);
+
+	StereoFrame block[AUDIO_BLOCK_SIZE];
+	int16_t pcm[AUDIO_BLOCK_SIZE * 2];
+	PerfWindow timings;
+	uint32_t windowsSeen = perf.windowCount();
+	uint32_t clipped = 0;
+	double renderSeconds = 0;
+	for (uint32_t frame = 0; frame < totalFrames; frame += AUDIO_BLOCK_SIZE) {
+		if (frame % FRAMES_PER_CONTROL == 0)
+			updateControl();
+
+		auto start = std::chrono::steady_clock::now();
+		renderBlock(block, AUDIO_BLOCK_SIZE);
+		renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		hostAdvance(AUDIO_BLOCK_SIZE);
+
+		// The status prints close a perf window about once a second; total them all
+		if (perf.windowCount() != windowsSeen) {
+			windowsSeen = perf.windowCount();
+			timings.merge(perf.retiredWindow());
+		}
+
+		// updateAudio() hands the DAC 22-bit frames; keep the top 16
+		for (size_t i = 0; i < AUDIO_BLOCK_SIZE; ++i) {
+			int32_t l = block[i].l >> 6, r = block[i].r >> 6;
+			clipped += (l != (int16_t)l) + (r != (int16_t)r);
+			pcm[2 * i] = (int16_t)constrain(l, -32768, 32767);
+			pcm[2 * i + 1] = (int16_t)constrain(r, -32768, 32767);
+		}
+		fwrite(pcm, sizeof(int16_t), AUDIO_BLOCK_SIZE * 2, wav);
+	}
+	fclose(wav);
+	timings.merge(perf.liveWindow());
+
+	double audioSeconds = (double)totalFrames / AUDIO_RATE;
+	printf("Rendered %.1f s to %s in %.2f s: %.1fx real time", audioSeconds, path, renderSeconds,
+		   audioSeconds / renderSeconds);
+	if (clipped)
+		printf(", %u samples clipped", clipped);
+	printf("\n");
+	uint64_t allTicks = 0;
+	for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+		allTicks += timings.stages[i].totalTicks;
+	}
+	for (int i = 0; i < PERF_STAGE_COUNT; ++i) {
+		if (timings.stages[i].count == 0)
+			continue;
+		printf("%-4s %5.1f%%, p99 %6.2f us/block\n", perfStageName(i),
+			   allTicks ? 100.0 * timings.stages[i].totalTicks / allTicks : 0.0,
+			   timings.stages[i].percentile(99) / (double)perfTicksPerMicro());
+	}
+	return 0;
+}
@@ -0,0 +1,121 @@
+// Host benchmark for Resampler (resampler.h): cost per output sample and aliasing, next to the phase increment mSample
+// uses for rate mismatch.
+//
+//     g++ -O2 -std=c++17 -I. tools/resampler_bench.cpp -o resampler_bench && ./resampler_bench
+//
+// For each source rate it plays sine tones through both converters into AUDIO_RATE and reports:
+//   cycles     per output sample, from the time stamp counter on x86 (nanoseconds elsewhere)
+//   1k THD+N   everything but a 1 kHz tone, relative to it
+//   edge       the same for a tone at 80% of the lower Nyquist frequency: images or interpolation error
+//   alias      output level for a tone between the two Nyquist frequencies, relative to the tone (downsampling only)
+
+#include "../resampler.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t ticks() { return __rdtsc(); }
+#else
+static uint64_t ticks() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+#endif
+
+static const uint32_t AUDIO_RATE = 32768;
+
+// A sample table holding a sine at the source rate, long enough for the run
+struct ToneSource {
+	static constexpr int OUTPUT_BITS = 15;
+	std::vector<int16_t> table;
+	size_t pos = 0;
+	ToneSource(double freq, uint32_t rate) : table(3 * rate) {
+		for (size_t i = 0; i < table.size(); ++i) {
+			table[i] = (int16_t)lround(30000 * sin(2 * M_PI * freq * i / rate));
+		}
+	}
+	int32_t next() { return table[pos++]; }
+	void start() { pos = 0; }
+};
+
+// What mSample does for rate mismatch: step through the source with a Q16 phase increment, dropping or repeating
+template <class Source>
+struct PhaseIncrement {
+	Source &source;
+	uint32_t frac = 0, increment;
+	int32_t current;
+	PhaseIncrement(Source &src, uint32_t sourceRate, uint32_t outputRate)
+		: source(src), increment((uint32_t)(((uint64_t)sourceRate << 16) / outputRate)), current(src.next()) {}
+	int32_t next() {
+		int32_t out = current;
+		for (frac += increment; frac >= 1u << 16; frac -= 1u << 16) {
+			current = source.next();
+		}
+		return out;
+	}
+};
+
+// Energy of x outside a least-squares fit of a sine at freq, over the fitted energy, in dB. With freq 0 the whole
+// signal counts as unwanted, relative to a full-scale tone
+static double residualDb(const std::vector<int32_t> &x, double freq) {
+	const size_t skip = 256; // filter warm-up
+	double ss = 0, sc = 0, cc = 0, xs = 0, xc = 0, xx = 0;
+	double w = 2 * M_PI * freq / AUDIO_RATE;
+	for (size_t i = skip; i < x.size(); ++i) {
+		double s = sin(w * i), c = cos(w * i);
+		ss += s * s, sc += s * c, cc += c * c;
+		xs += x[i] * s, xc += x[i] * c, xx += (double)x[i] * x[i];
+	}
+	if (freq == 0) {
+		double fullScale = 30000.0 * 30000.0 / 2 * (x.size() - skip);
+		return 10 * log10(xx / fullScale + 1e-30);
+	}
+	double det = ss * cc - sc * sc;
+	double fitted = ((xs * cc - xc * sc) * xs + (xc * ss - xs * sc) * xc) / det;
+	return 10 * log10((xx - fitted) / fitted + 1e-30);
+}
+
+template <template <class> class Converter>
+static std::vector<int32_t> run(double freq, uint32_t rate, double *ticksPerSample) {
+	const size_t samples = AUDIO_RATE * 2;
+	ToneSource tone(freq, rate);
+	Converter<ToneSource> converter(tone, rate, AUDIO_RATE);
+	std::vector<int32_t> out(samples);
+	uint64_t start = ticks();
+	for (size_t i = 0; i < samples; ++i) {
+		out[i] = converter.next();
+	}
+	if (ticksPerSample)
+		*ticksPerSample = (double)(ticks() - start) / samples;
+	return out;
+}
+
+template <class Source>
+using Polyphase = Resampler<Source>;
+
+template <template <class> class Converter>
+static void report(const char *name, uint32_t rate) {
+	double lowerNyquist = 0.5 * (rate < AUDIO_RATE ? rate : AUDIO_RATE);
+	double edge = 0.8 * lowerNyquist;
+	double cycles = 0;
+	double thd = residualDb(run<Converter>(1000, rate, &cycles), 1000);
+	double edgeDb = residualDb(run<Converter>(edge, rate, nullptr), edge);
+	printf("%6u Hz  %-16s %8.2f %10.1f %8.1f", rate, name, cycles, thd, edgeDb);
+	if (rate > AUDIO_RATE) {
+		double above = 0.5 * (AUDIO_RATE / 2.0 + rate / 2.0);
+		printf(" %8.1f", residualDb(run<Converter>(above, rate, nullptr), 0));
+	}
+	printf("\n");
+}
+
+int main() {
+	printf("source     converter           cycles  1k THD+N     edge    alias (dB)\n");
+	for (uint32_t rate : {16384u, 22050u, 44100u, 48000u}) {
+		report<PhaseIncrement>("phase increment", rate);
+		report<Polyphase>("polyphase 16x64", rate);
+	}
+	return 0;
+}
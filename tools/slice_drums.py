@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""Slice a drum loop at its transients for SlicedDrums (sliced_drums.h).
+
+Finds the hits in a loop of --steps sixteenths, keeps one copy of each distinct hit and writes them as IMA ADPCM
+(see adpcm_encode.py) together with the pattern: when each hit falls, in 1/65536ths of a step from the loop start, so
+playback can follow any tempo and swing on the sequencer's grid without resampling. A hit's slice runs to the next
+transient; repeats of the same hit share the longest slice.
+
+    python3 tools/slice_drums.py assets/neo_soul_drums.wav -o neo_soul_drums_slices.h
+
+tools/embed_assets.py runs the same slicing at build time for assets/assets.txt.
+"""
+
+import argparse
+import math
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from adpcm_encode import encode, read_header, read_wav  # noqa: E402
+
+FRAME = 256
+HOP = 64
+PRE_ROLL = 128  # samples kept ahead of a detected onset so the attack is intact
+
+
+def onsets(samples, threshold, min_gap):
+    energy = []
+    for t in range(0, len(samples) - FRAME, HOP):
+        frame = samples[t:t + FRAME]
+        energy.append(math.log10(1 + sum(v * v for v in frame) / FRAME))
+    flux = [0.0] + [max(0.0, energy[i] - energy[i - 1]) for i in range(1, len(energy))]
+    found = []
+    for i in range(1, len(flux) - 1):
+        if flux[i] < threshold or flux[i] < flux[i - 1] or flux[i] < flux[i + 1]:
+            continue
+        position = max(0, i * HOP - PRE_ROLL)
+        if found and position - found[-1][0] < min_gap:
+            if flux[i] > found[-1][1]:
+                found[-1] = (found[-1][0], flux[i])  # keep the earlier start, it has the attack
+            continue
+        found.append((position, flux[i]))
+    return [p for p, _ in found]
+
+
+def similarity(a, b, max_lag=32):
+    # over the whole of the shorter slice, so hits only merge when what follows the attack matches too
+    n = min(len(a), len(b))
+    best = 0.0
+    for lag in range(-max_lag, max_lag + 1):
+        x = a[max(0, lag):n]
+        y = b[max(0, -lag):n]
+        m = min(len(x), len(y))
+        dot = sum(x[i] * y[i] for i in range(m))
+        norm = math.sqrt(sum(v * v for v in x[:m]) * sum(v * v for v in y[:m]))
+        if norm:
+            best = max(best, dot / norm)
+    return best
+
+
+def slice_loop(samples, steps, threshold, min_gap, similar, block):
+    """Returns the hit starts, the distinct hits, which hit each start plays, where each hit starts in the packed
+    samples, the ADPCM data and the hit times in 1/65536 steps."""
+    starts = onsets(samples, threshold, min_gap)
+    if not starts:
+        sys.exit("no transients found; lower --threshold")
+
+    # Each slice runs to the next transient; the last one wraps around to the first
+    slices = []
+    for i, start in enumerate(starts):
+        if i + 1 < len(starts):
+            slices.append(samples[start:starts[i + 1]])
+        else:
+            slices.append(samples[start:] + samples[:starts[0]])
+
+    hits = []  # distinct slices
+    hit_of = []
+    for s in slices:
+        for h, hit in enumerate(hits):
+            if similarity(s, hit) >= similar:
+                if len(s) > len(hit):
+                    hits[h] = s
+                hit_of.append(h)
+                break
+        else:
+            hit_of.append(len(hits))
+            hits.append(s)
+
+    # Hits start on block boundaries so the decoder can jump straight to them
+    packed, hit_start = [], []
+    for hit in hits:
+        hit_start.append(len(packed))
+        packed += hit + [0] * (-len(hit) % block)
+    data, _ = encode(packed, block)
+
+    step = len(samples) / steps
+    hit_time = [round(start / step * 65536) for start in starts]
+    return starts, hits, hit_of, hit_start, packed, data, hit_time
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help=".wav or table header of the loop")
+    parser.add_argument("-o", "--output", required=True, help="header to write")
+    parser.add_argument("--name", help="table name (default: from the input)")
+    parser.add_argument("--steps", type=int, default=32, help="sixteenths in the loop")
+    parser.add_argument("--threshold", type=float, default=0.4, help="onset strength, in log10 energy per hop")
+    parser.add_argument("--min-gap", type=float, default=50, help="ms between separate hits")
+    parser.add_argument("--similar", type=float, default=0.9, help="correlation above which two hits are one")
+    parser.add_argument("--block", type=int, default=256, help="ADPCM samples per block")
+    parser.add_argument("--rate", type=int, default=32768, help="sample rate for .wav input")
+    args = parser.parse_args()
+
+    if args.input.endswith(".wav"):
+        name = args.name or os.path.splitext(os.path.basename(args.input))[0]
+        samples, rate = read_wav(args.input, args.rate), args.rate
+    else:
+        table, samples, rate = read_header(args.input)
+        name, rate = args.name or table, rate or args.rate
+
+    starts, hits, hit_of, hit_start, packed, data, hit_time = slice_loop(
+        samples, args.steps, args.threshold, int(args.min_gap * rate / 1000), args.similar, args.block)
+
+    guard = f"{name}_slices_H_"
+    with open(args.output, "w") as f:
+        f.write(f"#ifndef {guard}\n#define {guard}\n \n#include <Arduino.h>\n#include \"mozzi_pgmspace.h\"\n \n")
+        f.write(f"// Drum hits and pattern for SlicedDrums, generated by tools/slice_drums.py from "
+                f"{os.path.basename(args.input)}\n")
+        f.write(f"#define {name}_SLICES_SAMPLES {len(packed)}\n")
+        f.write(f"#define {name}_SLICES_BLOCK_SAMPLES {args.block}\n")
+        f.write(f"#define {name}_SLICES_SAMPLERATE {rate}\n")
+        f.write(f"#define {name}_SLICES_BYTES {len(data)}\n")
+        f.write(f"#define {name}_SLICE_COUNT {len(hits)}\n")
+        f.write(f"#define {name}_HIT_COUNT {len(starts)}\n")
+        f.write(f"#define {name}_LOOP_STEPS {args.steps}\n \n")
+        f.write(f"// First sample and length of each distinct hit\n")
+        f.write(f"const uint32_t {name}_SLICE_START[] = {{{', '.join(map(str, hit_start))}}};\n")
+        f.write(f"const uint32_t {name}_SLICE_LENGTH[] = {{{', '.join(str(len(h)) for h in hits)}}};\n \n")
+        f.write(f"// Pattern: when each hit plays, in 1/65536 steps from the loop start, and which slice\n")
+        f.write(f"const uint32_t {name}_HIT_TIME[] = {{{', '.join(map(str, hit_time))}}};\n")
+        f.write(f"const uint8_t {name}_HIT_SLICE[] = {{{', '.join(map(str, hit_of))}}};\n \n")
+        f.write(f"CONSTTABLE_STORAGE(uint8_t) {name}_SLICES_ADPCM [] = {{")
+        line = ""
+        for byte in data:
+            item = f"{byte}, "
+            if len(line) + len(item) > 80:
+                f.write(line.rstrip() + "\n")
+                line = ""
+            line += item
+        f.write(line + "};\n\n")
+        f.write(f"#endif /* {guard} */\n")
+
+    print(f"{name}: {len(starts)} hits, {len(hits)} distinct, {len(samples) * 2} -> {len(data)} bytes")
+
+
+if __name__ == "__main__":
+    main()
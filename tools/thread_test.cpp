@@ -0,0 +1,140 @@
+// Host test of the lock-free handovers between the control side and the audio side under DUAL_CORE: SpscMailbox
+// (mailbox.h), ParamSnapshot (param_snapshot.h) and the double-buffered PerfCounters (perf.h), each with a producer
+// and a consumer thread. Build it with ThreadSanitizer, which reports any data race the handovers let through:
+//
+//     g++ -O1 -g -std=c++17 -fsanitize=thread -Itools/host -I. tools/thread_test.cpp -o thread_test && ./thread_test
+//
+// Besides the sanitizer, each test checks what the consumer sees: every message in order, only whole parameter
+// blocks in increasing versions, and perf windows whose stage counts match their block count. It prints one line
+// per test and exits non-zero on the first failure.
+
+#include <Meap.h>
+
+#define AUDIO_BLOCK_SIZE 32 // as in the sketch
+#define AUDIO_PERF 1
+#include "mailbox.h"
+#include "param_snapshot.h"
+#include "perf.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+static void check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAIL: %s\n", what);
+		exit(1);
+	}
+}
+
+struct Message {
+	uint32_t sequence;
+	uint32_t check; // ~sequence, so a torn slot shows
+};
+
+static void testMailbox() {
+	const uint32_t COUNT = 1000000;
+	static SpscMailbox<Message, 64> mailbox;
+	std::thread producer([] {
+		for (uint32_t i = 0; i < COUNT; ++i) {
+			while (!mailbox.push({i, ~i})) {
+				std::this_thread::yield();
+			}
+		}
+	});
+	uint32_t expected = 0;
+	while (expected < COUNT) {
+		Message m;
+		if (!mailbox.pop(m)) {
+			std::this_thread::yield();
+			continue;
+		}
+		check(m.sequence == expected, "mailbox delivers every message once, in order");
+		check(m.check == ~m.sequence, "mailbox delivers whole messages");
+		++expected;
+	}
+	producer.join();
+	printf("SpscMailbox: %u messages in order\n", COUNT);
+}
+
+struct Params {
+	uint32_t fields[32]; // all equal to the version that wrote them
+};
+
+static void testSnapshot() {
+	const uint32_t COUNT = 200000;
+	static ParamSnapshot<Params> snapshot;
+	static std::atomic<bool> done{false};
+	std::thread writer([] {
+		Params p;
+		for (uint32_t version = 1; version <= COUNT; ++version) {
+			for (uint32_t &f : p.fields) {
+				f = version;
+			}
+			snapshot.publish(p);
+		}
+		done.store(true, std::memory_order_release);
+	});
+	uint32_t last = 0, fetched = 0;
+	for (;;) {
+		bool finished = done.load(std::memory_order_acquire);
+		if (snapshot.fetch()) {
+			const Params &p = snapshot.current();
+			check(snapshot.currentVersion() > last, "snapshot versions only move forward");
+			last = snapshot.currentVersion();
+			for (uint32_t f : p.fields) {
+				check(f == last, "snapshot hands over whole parameter blocks");
+			}
+			++fetched;
+		} else if (finished) {
+			break;
+		}
+	}
+	writer.join();
+	check(last == COUNT, "snapshot ends on the last version published");
+	printf("ParamSnapshot: %u versions, %u fetched whole\n", COUNT, fetched);
+}
+
+static void testPerf() {
+	const uint32_t BLOCKS = 200000;
+	static PerfCounters counters;
+	static std::atomic<bool> done{false};
+	hostSerialOut = nullptr; // printJson() output isn't checked, only that printing it doesn't race
+	std::thread audio([] {
+		for (uint32_t b = 0; b < BLOCKS; ++b) {
+			counters.blockStart();
+			for (int stage = 0; stage < PERF_STAGE_COUNT; ++stage) {
+				counters.lap((PerfStage)stage);
+			}
+			counters.blockEnd();
+		}
+		done.store(true, std::memory_order_release);
+	});
+	uint32_t windows = 0, blocks = 0;
+	while (!done.load(std::memory_order_acquire)) {
+		uint32_t seen = counters.windowCount();
+		counters.printJson(AUDIO_BLOCK_SIZE);
+		while (counters.windowCount() == seen && !done.load(std::memory_order_acquire)) {
+			std::this_thread::yield();
+		}
+		if (counters.windowCount() == seen)
+			break;
+		const PerfWindow &window = counters.retiredWindow();
+		for (int stage = 0; stage < PERF_STAGE_COUNT; ++stage) {
+			check(window.stages[stage].count == window.block.count, "a retired perf window holds whole blocks");
+		}
+		blocks += window.block.count;
+		++windows;
+	}
+	audio.join();
+	check(blocks <= BLOCKS, "no block is counted in two windows");
+	printf("PerfCounters: %u windows of %u blocks read while the audio thread ran\n", windows, blocks);
+}
+
+int main() {
+	testMailbox();
+	testSnapshot();
+	testPerf();
+	return 0;
+}
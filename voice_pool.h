@@ -0,0 +1,161 @@
+#ifndef VOICE_POOL_H
+#define VOICE_POOL_H
+
+#include "osc_bank.h"
+#include "placement.h"
+
+#include <Meap.h>
+
+// Fixed pool of MAX_VOICES enveloped oscillator voices, one OscBank lane each. Notes come in as note-on/note-off
+// events; a released voice rings out its release before its lane frees up. When every voice is busy a note-on steals
+// the quietest releasing voice, or the oldest held one if nothing is releasing; the stolen voice fades out over
+// STEAL_MS on its old note and then starts the new one from the zero crossing, like a free lane. All voices live in the
+// bank and are stepped every sample, so the render cost is fixed by MAX_VOICES however many notes sound;
+// setVoiceLimit() lowers the number of voices notes may use without changing that cost. INTERPOLATE selects the
+// bank's interpolating reads.
+template <unsigned int MAX_VOICES, unsigned int NUM_CELLS, unsigned int UPDATE_RATE, class T = int16_t,
+		  bool INTERPOLATE = false>
+class VoicePool {
+  private:
+	typedef OscBank<MAX_VOICES, NUM_CELLS, UPDATE_RATE, T, INTERPOLATE> Bank;
+
+	// Envelope levels are Q23 so long releases still move every sample; the bank takes the top 15 bits
+	static constexpr int LEVEL_BITS = 23;
+	static constexpr int32_t FULL_LEVEL = 1 << LEVEL_BITS;
+	static constexpr unsigned int STEAL_MS = 3;
+
+	struct Voice {
+		int note = -1;		   // MIDI note, -1 when free
+		bool held = false;	   // between note-on and note-off
+		int32_t level = 0;	   // envelope, Q23
+		uint32_t startedAt = 0; // note-on count at the last trigger, for stealing the oldest
+		bool stealing = false;	// fading out the previous note before note starts
+	};
+
+	Bank bank;
+	Voice voices[MAX_VOICES];
+	unsigned int voiceLimit = MAX_VOICES;
+	uint32_t noteCount = 0;
+	int32_t attackStep = 0;	 // per sample, Q23
+	int32_t releaseStep = 0; // per sample, Q23
+	int32_t stealStep = stepFor(STEAL_MS);
+
+	static int32_t stepFor(unsigned int ms) {
+		uint32_t samples = (uint32_t)UPDATE_RATE * (ms > 0 ? ms : 1) / 1000;
+		return FULL_LEVEL / (int32_t)(samples > 0 ? samples : 1);
+	}
+
+	int findVoice() {
+		int quietest = -1;
+		int oldest = -1;
+		for (unsigned int v = 0; v < voiceLimit; ++v) {
+			if (voices[v].note < 0)
+				return v;
+			if (!voices[v].held) {
+				if (quietest < 0 || voices[v].level < voices[quietest].level)
+					quietest = v;
+			} else if (oldest < 0 || (int32_t)(voices[v].startedAt - voices[oldest].startedAt) < 0) {
+				oldest = v;
+			}
+		}
+		return quietest >= 0 ? quietest : oldest;
+	}
+
+  public:
+	// Magnitude bound of render() output for the mix bus: every voice at full level
+	static constexpr int OUTPUT_BITS = Bank::OUTPUT_BITS;
+
+	VoicePool(const T *table_data, unsigned int attackMs = 5, unsigned int releaseMs = 300) : bank(table_data) {
+		for (unsigned int v = 0; v < MAX_VOICES; ++v) {
+			bank.setGain(v, 0);
+		}
+		bank.next(); // settle on the silent gains now rather than ramping down from unity
+		setAttack(attackMs);
+		setRelease(releaseMs);
+	}
+
+	void setAttack(unsigned int ms) { attackStep = stepFor(ms); }
+
+	void setRelease(unsigned int ms) { releaseStep = stepFor(ms); }
+
+	// Caps how many voices notes may take, 1..MAX_VOICES. Voices above the cap finish their notes and stay free
+	void setVoiceLimit(unsigned int limit) { voiceLimit = constrain(limit, 1u, MAX_VOICES); }
+
+	// Starts midiNote and returns its voice. A note that is still sounding is retriggered in place
+	int noteOn(int midiNote) {
+		++noteCount;
+		for (unsigned int v = 0; v < voiceLimit; ++v) {
+			if (voices[v].note == midiNote) {
+				voices[v].held = true;
+				voices[v].startedAt = noteCount;
+				return v;
+			}
+		}
+
+		int v = findVoice();
+		Voice &voice = voices[v];
+		if (voice.note < 0 || voice.level == 0) {
+			bank.setPhase(v); // a free lane is silent, so it can restart at the zero crossing
+			bank.setFreq(v, mtof(midiNote));
+		} else {
+			voice.stealing = true; // still sounding: render() retunes it once it has faded out
+		}
+		voice.note = midiNote;
+		voice.held = true;
+		voice.startedAt = noteCount;
+		return v;
+	}
+
+	void noteOff(int midiNote) {
+		for (unsigned int v = 0; v < MAX_VOICES; ++v) {
+			if (voices[v].note == midiNote)
+				voices[v].held = false;
+		}
+	}
+
+	void releaseAll() {
+		for (unsigned int v = 0; v < MAX_VOICES; ++v) {
+			voices[v].held = false;
+		}
+	}
+
+	unsigned int activeVoices() const {
+		unsigned int count = 0;
+		for (unsigned int v = 0; v < MAX_VOICES; ++v) {
+			count += voices[v].note >= 0;
+		}
+		return count;
+	}
+
+	// Advances every envelope by one block and renders the voices into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		int32_t attack = attackStep * (int32_t)n;
+		int32_t release = releaseStep * (int32_t)n;
+		int32_t steal = stealStep * (int32_t)n;
+		for (unsigned int v = 0; v < MAX_VOICES; ++v) {
+			Voice &voice = voices[v];
+			if (voice.note < 0)
+				continue;
+			if (voice.stealing && voice.level == 0) {
+				// The lane's gain ramped to zero over the last block, so it can take the new note silently
+				voice.stealing = false;
+				bank.setPhase(v);
+				bank.setFreq(v, mtof(voice.note));
+			}
+			if (voice.stealing) {
+				voice.level = voice.level > steal ? voice.level - steal : 0;
+			} else if (voice.held && v < voiceLimit) {
+				voice.level = voice.level < FULL_LEVEL - attack ? voice.level + attack : FULL_LEVEL;
+			} else {
+				voice.held = false;
+				voice.level = voice.level > release ? voice.level - release : 0;
+				if (voice.level == 0)
+					voice.note = -1;
+			}
+			bank.setGain(v, voice.level >> (LEVEL_BITS - Bank::GAIN_BITS));
+		}
+		bank.render(buf, n);
+	}
+};
+
+#endif
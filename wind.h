@@ -2,6 +2,7 @@
 #define WIND_H
 
 #include "enableable.h"
+#include "placement.h"
 #include <Meap.h>
 #include <tables/whitenoise8192_int8.h>
 
@@ -14,10 +15,17 @@ class Wind : public Enableable {
 	int resonance = 255;
 
   public:
+	// Magnitude bound of render() output for the mix bus: 8-bit noise, one bit of resonance peak, 12-bit volume >> 4.
+	// At full resonance and a low cutoff the filter rings several times past that, so the output saturates there
+	static constexpr int OUTPUT_BITS = 7 + 1 + 12 - 4;
+
 	Wind() : white_noise(WHITENOISE8192_DATA) {
 		white_noise.setFreq(1.0f); // Standard reading rate for noise
 	}
 
+	// Swaps in a copy of the noise table, e.g. one placed in RAM
+	void setNoiseTable(const int8_t *table) { white_noise.setTable(table); }
+
 	void setVolume(int vol) { volume = constrain(vol, 0, 4095); }
 
 	int getVolume() { return volume; }
@@ -32,11 +40,16 @@ class Wind : public Enableable {
 
 	int getResonance() { return resonance; }
 
-	int64_t next() {
+	static int32_t saturate(int32_t x) {
+		const int32_t limit = int32_t(1) << OUTPUT_BITS;
+		return x > limit ? limit : (x < -limit ? -limit : x);
+	}
+
+	int32_t AUDIO_HOT next() {
 		if (Enableable::isEnabled()) {
-			int64_t sample = white_noise.next();
+			int32_t sample = white_noise.next();
 			filter.next(sample);
-			int64_t filtered = filter.low(); // Using low pass as per original code behavior
+			int32_t filtered = filter.low(); // Using low pass as per original code behavior
 
 			// Apply volume and scale.
 			// Original code: out_sample += white_noise_out_sample << 4;
@@ -44,10 +57,23 @@ class Wind : public Enableable {
 			// If input is 8-bit (-128 to 127) and volume is 0-4095 (12-bit).
 			// (sample * volume) >> 4 gives roughly (128 * 4096) / 16 = 32768 range (16-bit).
 			// Effectively same as sample << 8 when volume is max.
-			return (filtered * volume) >> 4;
+			return saturate((filtered * volume) >> 4);
 		}
 		return 0;
 	}
+
+	// Renders n samples into buf, overwriting it
+	void AUDIO_HOT render(int32_t *buf, size_t n) {
+		if (!Enableable::isEnabled()) {
+			memset(buf, 0, n * sizeof(int32_t));
+			return;
+		}
+		for (size_t i = 0; i < n; ++i) {
+			filter.next(white_noise.next());
+			int32_t filtered = filter.low();
+			buf[i] = saturate((filtered * volume) >> 4);
+		}
+	}
 };
 
 #endif